@@ -0,0 +1,116 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench.h holds what the benchmarks share, timing and, for a benchmark that defines BENCH_COUNT_ALLOCATIONS before including it,
+counting the allocations made and the memory in use
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+#pragma once
+
+#include <chrono>
+
+
+// milliseconds taken by f(), or the mean of repeat runs
+template <typename F> inline double time_ms (int repeat, F f)
+{
+	auto start = std::chrono::steady_clock::now();
+	for (int r = 0; r < repeat; ++r)
+		f();
+	return std::chrono::duration<double, std::milli> (std::chrono::steady_clock::now() - start) .count() / repeat;
+}
+
+template <typename F> inline double time_ms (F f)
+{
+	return time_ms (1, f);
+}
+
+
+#if defined (BENCH_COUNT_ALLOCATIONS)
+
+#include <atomic>
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+#if defined (_WIN32)
+#include <malloc.h>
+#endif
+
+// replaces every form of the global operator new and delete, so it must be included in only one source file of a program
+// each block is prefixed with its size so that the memory in use, and the most in use at once, can be kept
+static std::atomic<size_t> allocations {0};
+static std::atomic<size_t> inUse {0};
+static std::atomic<size_t> peak {0};
+
+// room for the size ahead of a block, keeping the block aligned
+static size_t block_prefix (size_t alignment)
+{
+	return alignment > alignof (std::max_align_t) ? alignment : alignof (std::max_align_t);
+}
+
+static void * counted_allocate (size_t size, size_t alignment)
+{
+	auto prefix = block_prefix (alignment);
+	auto total = (size + prefix + prefix - 1) / prefix * prefix;
+#if defined (_WIN32)
+	auto p = static_cast<char *> (_aligned_malloc (total, prefix));
+#else
+	auto p = static_cast<char *> (std::aligned_alloc (prefix, total));
+#endif
+	if (!p)
+		throw std::bad_alloc();
+	*reinterpret_cast<size_t *> (p + prefix - sizeof (size_t)) = size;
+	++allocations;
+	auto used = inUse += size;
+	for (auto most = peak .load(); used > most && !peak .compare_exchange_weak (most, used); )
+		;
+	return p + prefix;
+}
+
+static void counted_release (void * block, size_t alignment) noexcept
+{
+	if (!block)
+		return;
+	auto prefix = block_prefix (alignment);
+	auto p = static_cast<char *> (block) - prefix;
+	inUse -= *reinterpret_cast<size_t *> (p + prefix - sizeof (size_t));
+#if defined (_WIN32)
+	_aligned_free (p);
+#else
+	std::free (p);
+#endif
+}
+
+void * operator new (size_t size) { return counted_allocate (size, 0); }
+void * operator new [] (size_t size) { return counted_allocate (size, 0); }
+void * operator new (size_t size, std::align_val_t alignment) { return counted_allocate (size, static_cast<size_t> (alignment)); }
+void * operator new [] (size_t size, std::align_val_t alignment) { return counted_allocate (size, static_cast<size_t> (alignment)); }
+
+void operator delete (void * block) noexcept { counted_release (block, 0); }
+void operator delete [] (void * block) noexcept { counted_release (block, 0); }
+void operator delete (void * block, size_t) noexcept { counted_release (block, 0); }
+void operator delete [] (void * block, size_t) noexcept { counted_release (block, 0); }
+void operator delete (void * block, std::align_val_t alignment) noexcept { counted_release (block, static_cast<size_t> (alignment)); }
+void operator delete [] (void * block, std::align_val_t alignment) noexcept { counted_release (block, static_cast<size_t> (alignment)); }
+void operator delete (void * block, size_t, std::align_val_t alignment) noexcept { counted_release (block, static_cast<size_t> (alignment)); }
+void operator delete [] (void * block, size_t, std::align_val_t alignment) noexcept { counted_release (block, static_cast<size_t> (alignment)); }
+
+#endif
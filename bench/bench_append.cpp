@@ -0,0 +1,97 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_append.cpp times building a large export one append_element call per row
+against append_elements with a projection to attributes and with a callback, counting the allocations made
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+// counts allocations, replacing the global operator new and delete
+#define BENCH_COUNT_ALLOCATIONS
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <array>
+#include <chrono>
+#include <iostream>
+
+#include <tixml2ex.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+struct Row
+{
+	string id;
+	string name;
+	string amount;
+};
+
+
+template <typename F> static void time_export (const char * how, size_t nRows, F build)
+{
+	auto doc = make_unique<tinyxml2::XMLDocument>();
+	auto parent = doc -> NewElement ("Export");
+	doc -> InsertEndChild (parent);
+	auto before = allocations .load();
+	auto start = chrono::steady_clock::now();
+	build (parent);
+	auto ms = chrono::duration<double, milli> (chrono::steady_clock::now() - start) .count();
+	cout << "   " << how << " " << ms << " ms, " << (allocations - before) / nRows << " allocations per row" << endl;
+}
+
+
+int main (int argc, char * argv [])
+{
+	size_t nRows = argc > 1 ? stoul (argv [1]) : 1000000;
+	vector<Row> rows;
+	for (size_t n = 0; n < nRows; ++n)
+		rows .push_back (Row {to_string (n), "row "s + to_string (n), to_string (n * 7)});
+	cout << nRows << " rows" << endl;
+
+	time_export ("append_element per row", nRows, [&rows] (tinyxml2::XMLElement * parent)
+	{
+		for (auto const & row : rows)
+			append_element (parent, "Row[@type='r']", {{"id"s, row .id}, {"name"s, row .name}, {"amount"s, row .amount}});
+	});
+
+	const tinyxml2::XPath rowPath {"Row[@type='r']"};
+	time_export ("append_elements, projection", nRows, [&] (tinyxml2::XMLElement * parent)
+	{
+		append_elements (parent, rowPath, rows, [] (const Row & row)
+		{
+			return array<pair<const char *, const char *>, 3> {{{"id", row .id .c_str()}, {"name", row .name .c_str()}, {"amount", row .amount .c_str()}}};
+		});
+	});
+	time_export ("append_elements, callback", nRows, [&] (tinyxml2::XMLElement * parent)
+	{
+		append_elements (parent, rowPath, rows, [] (const Row & row, tinyxml2::XMLElement * element)
+		{
+			element -> SetAttribute ("id", row .id .c_str());
+			element -> SetAttribute ("name", row .name .c_str());
+			element -> SetAttribute ("amount", row .amount .c_str());
+		});
+	});
+	return 0;
+}
@@ -0,0 +1,87 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_cache.cpp times answering the same queries over and over against a slowly changing document,
+selecting each time against a SelectionCache, with and without changes to the document between queries
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include <tixml2ex.h>
+#include "bench_generator.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+int main (int argc, char * argv [])
+{
+	size_t nQueries = argc > 1 ? stoul (argv [1]) : 1000000;
+	const DocumentShape shape {"config", 4, 10, 4, 8};
+	auto doc = tinyxml2::load_document (generate_xml (shape));
+	cout << nQueries << " queries against " << shape .Elements() << " elements" << endl;
+
+	// settings looked up by position at each level
+	vector<tinyxml2::XPath> queries;
+	for (int n = 0; n < 16; ++n)
+	{
+		string path = level_name (0);
+		for (int level = 1; level <= shape .depth; ++level)
+			path += "/"s + level_name (level) + "[@ix='"s + to_string ((n * 7 + level * 3) % shape .fanOut) + "']"s;
+		queries .emplace_back (path);
+	}
+
+	// changes go below an element at the bottom level, where they don't lengthen the searches
+	auto leaf = find_element (*doc, level_path (shape));
+	auto time_queries = [&] (const char * how, size_t changeEvery, auto find)
+	{
+		size_t found = 0;
+		auto start = chrono::steady_clock::now();
+		for (size_t n = 0; n < nQueries; ++n)
+		{
+			if (changeEvery && n % changeEvery == 0)
+				append_element (leaf, "changed");
+			found += find (queries [n % queries .size()]) != nullptr;
+		}
+		auto ns = chrono::duration<double, nano> (chrono::steady_clock::now() - start) .count() / nQueries;
+		cout << "   " << how << " " << ns << " ns per query, " << found << " found" << endl;
+	};
+
+	time_queries ("find_element", 0, [&] (const tinyxml2::XPath & xpath) { return find_element (*doc, xpath); });
+	{
+		tinyxml2::SelectionCache cache (*doc);
+		time_queries ("cached", 0, [&] (const tinyxml2::XPath & xpath) { return find_element (*doc, xpath, cache); });
+		cout << "      " << cache .Hits() << " hits, " << cache .Misses() << " misses" << endl;
+	}
+	for (size_t changeEvery : {10000, 100})
+	{
+		tinyxml2::SelectionCache cache (*doc);
+		auto how = "cached, changed every "s + to_string (changeEvery) + " queries"s;
+		time_queries (how .c_str(), changeEvery, [&] (const tinyxml2::XPath & xpath) { return find_element (*doc, xpath, cache); });
+		cout << "      " << cache .Hits() << " hits, " << cache .Misses() << " misses" << endl;
+	}
+	return 0;
+}
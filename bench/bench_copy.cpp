@@ -0,0 +1,80 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_copy.cpp times copying a large template with the XMLCopy visitor, with xcopy and with a filtered xcopy,
+counting the allocations made
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+// counts allocations, replacing the global operator new and delete
+#define BENCH_COUNT_ALLOCATIONS
+
+#include <string>
+#include <chrono>
+#include <iostream>
+
+#include <tixml2cx.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+template <typename F> static void time_copy (const char * how, F copy)
+{
+	auto destination = make_unique<tinyxml2::XMLDocument>();
+	auto parent = destination -> NewElement ("Out");
+	destination -> InsertEndChild (parent);
+	auto before = allocations .load();
+	auto start = chrono::steady_clock::now();
+	copy (parent);
+	auto ms = chrono::duration<double, milli> (chrono::steady_clock::now() - start) .count();
+	size_t nElements = 0;
+	for (auto element = parent; element; element = tinyxml2::next_element (element, destination .get()))
+		++nElements;
+	cout << "   " << how << " " << ms << " ms, " << allocations - before << " allocations, " << nElements << " elements" << endl;
+}
+
+
+int main (int argc, char * argv [])
+{
+	size_t nRecords = argc > 1 ? stoul (argv [1]) : 100000;
+	string xml {"<Template>"};
+	for (size_t n = 0; n < nRecords; ++n)
+		xml += "<Record id='"s + to_string (n) + "' type='t'><Name lang='en'>record "s + to_string (n) + "</Name><Value>"s + to_string (n * 7)
+				+ "</Value><!-- note --><Internal secret='s'><Detail/></Internal></Record>"s;
+	xml += "</Template>";
+	auto source = tinyxml2::load_document (xml);
+	auto root = source -> RootElement();
+	cout << nRecords << " records" << endl;
+
+	time_copy ("XMLCopy visitor", [root] (tinyxml2::XMLElement * parent)
+	{
+		tinyxml2::XMLCopy copier (parent);
+		root -> Accept (&copier);
+	});
+	time_copy ("xcopy", [root] (tinyxml2::XMLElement * parent) { xcopy (root, parent); });
+	time_copy ("xcopy without <Internal>", [root] (tinyxml2::XMLElement * parent)
+	{
+		xcopy (root, parent, [] (const tinyxml2::XMLElement * element) { return strcmp (element -> Name(), "Internal") != 0; });
+	});
+	return 0;
+}
@@ -0,0 +1,122 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_descendant.cpp compares selecting with the descendant axis, '//', with and without a DocumentIndex,
+against a hand-written XMLVisitor walk collecting the same elements
+
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+
+#include <tixml2ex.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+// what we'd write without '//', collect every element with name and, optionally, attribute present
+class Collector : public tinyxml2::XMLVisitor
+{
+public:
+	Collector (const char * name, const char * attribute) : _name (name), _attribute (attribute) {}
+
+	bool VisitEnter (const tinyxml2::XMLElement & element, const tinyxml2::XMLAttribute *) override
+	{
+		if (strcmp (element .Name(), _name) == 0 && (!_attribute || element .Attribute (_attribute)))
+			++_count;
+		return true;
+	}
+	size_t Count() const { return _count; }
+
+private:
+	const char * _name;
+	const char * _attribute;
+	size_t _count {0};
+};
+
+
+// every element has fanOut children, named "item" every seventh and otherwise "node", one in every 100 with attribute hit
+static void grow (tinyxml2::XMLElement * parent, int depth, int fanOut, int & serial)
+{
+	if (depth == 0)
+		return;
+	for (int n = 0; n < fanOut; ++n)
+	{
+		auto e = parent -> GetDocument() -> NewElement (++serial % 7 == 0 ? "item" : "node");
+		if (serial % 100 == 0)
+			e -> SetAttribute ("hit", 1);
+		parent -> InsertEndChild (e);
+		grow (e, depth - 1, fanOut, serial);
+	}
+}
+
+
+static void compare (const string & title, int depth, int fanOut, const string & xpath, const char * name, const char * attribute, int repeat)
+{
+	tinyxml2::XMLDocument doc;
+	auto root = doc .NewElement ("root");
+	doc .InsertEndChild (root);
+	int serial = 0;
+	grow (root, depth, fanOut, serial);
+	const tinyxml2::XPath compiled {xpath};
+	tinyxml2::DocumentIndex index (doc);
+
+	size_t nSelected = 0, nIndexed = 0, nVisited = 0;
+	auto selected = time_ms (repeat, [&]
+	{
+		nSelected = 0;
+		for (auto e : tinyxml2::selection (static_cast<const tinyxml2::XMLDocument &> (doc), compiled))
+			nSelected += e != nullptr;
+	});
+	auto indexed = time_ms (repeat, [&]
+	{
+		nIndexed = 0;
+		for (auto e : tinyxml2::selection (static_cast<const tinyxml2::XMLDocument &> (doc), compiled, index))
+			nIndexed += e != nullptr;
+	});
+	auto visited = time_ms (repeat, [&]
+	{
+		Collector collector (name, attribute);
+		doc .Accept (&collector);
+		nVisited = collector .Count();
+	});
+
+	cout << title << " " << xpath << ", " << serial << " elements : " << nSelected << " matches" << endl
+		<< "   selection " << selected << " ms, indexed " << indexed << " ms, visitor " << visited << " ms" << endl;
+	if (nSelected != nVisited || nIndexed != nVisited)
+		cout << "**FAILED** visitor found " << nVisited << " matches, indexed selection " << nIndexed << endl;
+}
+
+
+int main()
+{
+	compare ("bushy", 7, 7, "//item", "item", nullptr, 5);
+	compare ("bushy, sparse matches", 7, 7, "//item[@hit]", "item", "hit", 5);
+	compare ("deep", 20, 2, "root//item", "item", nullptr, 5);
+	compare ("wide", 1, 500000, "root//item[@hit]", "item", "hit", 5);
+	return 0;
+}
@@ -0,0 +1,92 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_file.cpp times load_document_file on a large generated file against reading the file into a string for load_document
+usage: bench_file [megabytes [string|mapped]], run each way separately to compare peak memory
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <cstdio>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <tixml2fx.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+static string peak_memory()
+{
+#ifdef _WIN32
+	return "n/a"s;
+#else
+	rusage usage;
+	getrusage (RUSAGE_SELF, &usage);
+	return to_string (usage .ru_maxrss / 1024) + " MB"s;		// Linux reports kB
+#endif
+}
+
+
+int main (int argc, char * argv [])
+{
+	size_t megabytes = argc > 1 ? stoul (argv [1]) : 200;
+	string how = argc > 2 ? argv [2] : "both"s;
+	string path = "bench_file.xml"s;
+	{
+		ofstream file (path, ios::binary);
+		file << "<Feed>\n";
+		string record;
+		for (size_t n = 0, size = 0; size < megabytes << 20; ++n, size += record .size())
+		{
+			record = "<Record id='"s + to_string (n) + "'><Name>record "s + to_string (n) + "</Name><Value>"s + to_string (n * 7) + "</Value></Record>\n"s;
+			file << record;
+		}
+		file << "</Feed>\n";
+	}
+	cout << megabytes << " MB file, peak memory before loading " << peak_memory() << endl;
+
+	if (how != "mapped"s)
+	{
+		auto ms = time_ms ([&]
+		{
+			ifstream file (path, ios::binary);
+			stringstream buffer;
+			buffer << file .rdbuf();
+			auto doc = tinyxml2::load_document (buffer .str());
+		});
+		cout << "   read into string " << ms << " ms, peak memory " << peak_memory() << endl;
+	}
+	if (how != "string"s)
+	{
+		auto ms = time_ms ([&] { auto doc = tinyxml2::load_document_file (path); });
+		cout << "   load_document_file " << ms << " ms, peak memory " << peak_memory() << endl;
+	}
+	remove (path .c_str());
+	return 0;
+}
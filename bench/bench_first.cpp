@@ -0,0 +1,64 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_first.cpp times find_first_in_buffer against load_document and find_element
+for an element at the start, middle and end of a large message
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+#include <string>
+#include <chrono>
+#include <iostream>
+
+#include <tixml2fx.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+int main (int argc, char * argv [])
+{
+	size_t nRecords = argc > 1 ? stoul (argv [1]) : 200000;
+	string xml {"<Message><Header id='42'><From>bench</From></Header><Body>"};
+	for (size_t n = 0; n < nRecords; ++n)
+	{
+		if (n == nRecords / 2)
+			xml += "<Marker/>";
+		xml += "<Record id='"s + to_string (n) + "'><Name>record "s + to_string (n) + "</Name></Record>"s;
+	}
+	xml += "</Body><Trailer count='"s + to_string (nRecords) + "'/></Message>"s;
+	cout << xml .size() / 1024 << " kB message" << endl;
+
+	for (auto path : {"Message/Header"s, "Message/Body/Marker"s, "Message/Trailer"s})
+	{
+		const tinyxml2::XPath xpath {path};
+		bool found = false;
+		auto whole = time_ms ([&]
+		{
+			auto doc = tinyxml2::load_document (xml);
+			found = !!find_element (*doc, xpath);
+		});
+		auto first = time_ms ([&] { found &= !!tinyxml2::find_first_in_buffer (xml, xpath); });
+		cout << "   " << path << " : load_document " << whole << " ms, find_first_in_buffer " << first << " ms" << (found ? ""s : " **NOT FOUND**"s) << endl;
+	}
+	return 0;
+}
@@ -0,0 +1,133 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_generator.h makes synthetic XML documents for the benchmarks, of any depth, fan-out, number of attributes and amount of text
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+#pragma once
+
+#include <string>
+
+#include <tixml2wx.h>
+
+
+// the shape of a generated document
+// below the document element <n0> every element has fanOut children, named by level n1, n2 ... down to depth
+// each element has attributes id, unique in the document, and ix, its position among its siblings from 0, then a2, a3 ... up to attributes
+// elements at the bottom level have text of textSize characters
+// with parameters, every other attribute value and text refer to template parameters {p0}, {p1} and {p2}
+struct DocumentShape
+{
+	const char * name;
+	int depth;
+	int fanOut;
+	int attributes;
+	size_t textSize;
+	bool parameters {false};
+
+	// number of elements, not counting the document element
+	size_t Elements() const
+	{
+		size_t n = 0;
+		for (size_t level = 1, width = 1; level <= (size_t) depth; ++level)
+			n += width *= fanOut;
+		return n;
+	}
+};
+
+
+// name of the elements at level
+inline std::string level_name (int level)
+{
+	return "n" + std::to_string (level);
+}
+
+// path from the document to the bottom level, optionally with a filter on every step below the document element
+inline std::string level_path (const DocumentShape & shape, const std::string & filter = {})
+{
+	std::string path = level_name (0);
+	for (int level = 1; level <= shape .depth; ++level)
+		path += "/" + level_name (level) + filter;
+	return path;
+}
+
+
+class DocumentGenerator
+{
+public:
+	explicit DocumentGenerator (const DocumentShape & shape) : _shape (shape)
+	{
+		// text mixes in characters that must be escaped
+		for (size_t n = 0; n < _shape .textSize; ++n)
+			_text += n % 64 == 63 ? '&' : (char) ('a' + n % 26);
+	}
+
+	std::string Xml()
+	{
+		std::string xml;
+		xml .reserve (_shape .Elements() * (32 + 12 * _shape .attributes + _shape .textSize));
+		{
+			tinyxml2::XmlWriter writer (xml);
+			_id = 0;
+			writer .Open (level_name (0));
+			element (writer, 1);
+		}
+		return xml;
+	}
+
+private:
+	void element (tinyxml2::XmlWriter & writer, int level)
+	{
+		auto name = level_name (level);
+		for (int ix = 0; ix < _shape .fanOut; ++ix)
+		{
+			writer .Open (name);
+			writer .Attribute ("id", std::to_string (++_id));
+			writer .Attribute ("ix", std::to_string (ix));
+			for (int a = 2; a < _shape .attributes; ++a)
+				writer .Attribute ("a" + std::to_string (a), value (a));
+			if (level < _shape .depth)
+				element (writer, level + 1);
+			else if (!_text .empty())
+				writer .Text (_shape .parameters ? "{p0}" + _text + "{p1}" : _text);
+			writer .Close();
+		}
+	}
+
+	std::string value (int a) const
+	{
+		auto v = "v" + std::to_string (_id % 97);
+		if (_shape .parameters && a % 2 == 0)
+			return "{p" + std::to_string (a % 3) + "}." + v;
+		return v;
+	}
+
+	DocumentShape _shape;
+	std::string _text;
+	size_t _id {0};
+};	// DocumentGenerator
+
+
+inline std::string generate_xml (const DocumentShape & shape)
+{
+	return DocumentGenerator (shape) .Xml();
+}
@@ -0,0 +1,79 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_loading.cpp times load_documents on a batch of small documents with 1 to N threads
+against loading them one at a time with load_document
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <iostream>
+
+#include <tixml2px.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+int main (int argc, char * argv [])
+{
+	size_t nDocuments = argc > 1 ? stoul (argv [1]) : 5000;
+	size_t nRecords = argc > 2 ? stoul (argv [2]) : 100;
+	vector<string> xmlStrings;
+	for (size_t ixDocument = 0; ixDocument < nDocuments; ++ixDocument)
+	{
+		string xml {"<Feed>"};
+		for (size_t n = 0; n < nRecords; ++n)
+			xml += "<Record id='"s + to_string (n) + "'><Name>record "s + to_string (n) + "</Name><Value>"s + to_string (n * 7) + "</Value></Record>"s;
+		xmlStrings .push_back (xml + "</Feed>");
+	}
+
+	size_t nElements = 0;
+	auto sequential = time_ms ([&]
+	{
+		for (auto & xml : xmlStrings)
+			nElements += !!tinyxml2::load_document (xml) -> RootElement();
+	});
+	cout << nDocuments << " documents of " << nRecords << " records, sequential " << sequential << " ms" << endl;
+
+	auto nHardware = max (1u, thread::hardware_concurrency());
+	for (unsigned nThreads = 1; ; nThreads = min (nThreads * 2, nHardware))
+	{
+		tinyxml2::ThreadPool pool (nThreads);
+		size_t nLoaded = 0;
+		auto parallel = time_ms ([&]
+		{
+			// documents are released as they're consumed, holding at most 64 at a time
+			tinyxml2::load_documents (xmlStrings, [&nLoaded] (size_t, tinyxml2::LoadResult && result) { nLoaded += !!result; }, pool, 64);
+		});
+		// the calling thread loads documents alongside the pool
+		cout << "   " << nThreads << " workers " << parallel << " ms, speed-up x" << sequential / parallel << endl;
+		if (nLoaded != nElements)
+			cout << "**FAILED** " << nDocuments - nLoaded << " documents not loaded" << endl;
+		if (nThreads == nHardware)
+			break;
+	}
+	return 0;
+}
@@ -0,0 +1,99 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_parallel.cpp times parallel_for_each over a synthetic feed of records with 1 to N threads
+against a sequential loop over the same selection
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <iostream>
+
+#include <tixml2px.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+// a stand-in for a per-record transform, reads the record's fields and does some arithmetic on them
+static uint64_t transform (const tinyxml2::XMLElement * record)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (int pass = 0; pass < 20; ++pass)
+	{
+		for (auto field = record -> FirstChildElement(); field; field = field -> NextSiblingElement())
+		{
+			for (auto c : tinyxml2::text_view (field))
+				hash = (hash ^ static_cast<unsigned char> (c)) * 1099511628211ull;
+			for (auto c : tinyxml2::attribute_view (field, "type"))
+				hash = (hash ^ static_cast<unsigned char> (c)) * 1099511628211ull;
+		}
+	}
+	return hash;
+}
+
+
+int main (int argc, char * argv [])
+{
+	size_t nRecords = argc > 1 ? stoul (argv [1]) : 500000;
+	string xml {"<Feed>"};
+	for (size_t n = 0; n < nRecords; ++n)
+		xml += "<Record id='"s + to_string (n) + "'><Name type='s'>record "s + to_string (n) + "</Name><Value type='n'>"s + to_string (n * 7) + "</Value></Record>"s;
+	xml += "</Feed>";
+
+	const tinyxml2::XPath records {"Feed/Record"};
+	uint64_t expected = 0;
+	double sequential;
+	{
+		auto doc = tinyxml2::load_document (xml);
+		sequential = time_ms ([&]
+		{
+			for (auto record : tinyxml2::selection (static_cast<const tinyxml2::XMLDocument &> (*doc), records))
+				expected ^= transform (record);
+		});
+	}
+	cout << nRecords << " records, sequential " << sequential << " ms" << endl;
+
+	auto nHardware = max (1u, thread::hardware_concurrency());
+	for (unsigned nThreads = 1; ; nThreads = min (nThreads * 2, nHardware))
+	{
+		// each run gets a freshly loaded document, so priming is included in the time
+		auto doc = tinyxml2::load_document (xml);
+		tinyxml2::ThreadPool pool (nThreads);
+		atomic<uint64_t> result {0};
+		auto parallel = time_ms ([&]
+		{
+			tinyxml2::parallel_for_each (tinyxml2::selection (static_cast<const tinyxml2::XMLDocument &> (*doc), records),
+				[&] (const tinyxml2::XMLElement * record) { result ^= transform (record); }, pool);
+		});
+		// the calling thread works through tasks alongside the pool
+		cout << "   " << nThreads << " workers " << parallel << " ms, speed-up x" << sequential / parallel << endl;
+		if (result != expected)
+			cout << "**FAILED** results differ from the sequential loop" << endl;
+		if (nThreads == nHardware)
+			break;
+	}
+	return 0;
+}
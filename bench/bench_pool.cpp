@@ -0,0 +1,68 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_pool.cpp times loading many small documents, and counts the allocations made,
+with load_document and with documents reused from a DocumentPool
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+// counts allocations, replacing the global operator new and delete
+#define BENCH_COUNT_ALLOCATIONS
+
+#include <string>
+#include <chrono>
+#include <iostream>
+
+#include <tixml2ex.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+int main (int argc, char * argv [])
+{
+	size_t nRequests = argc > 1 ? stoul (argv [1]) : 100000;
+	string xml {"<Request>"};
+	for (size_t n = 0; n < 20; ++n)
+		xml += "<Item id='"s + to_string (n) + "'>item "s + to_string (n) + "</Item>"s;
+	xml += "</Request>";
+	string_view request {xml};
+
+	size_t found = 0;
+	auto before = allocations .load();
+	auto ms = time_ms ([&]
+	{
+		for (size_t n = 0; n < nRequests; ++n)
+			found += !!tinyxml2::load_document (request) -> RootElement();
+	});
+	cout << nRequests << " requests, load_document " << ms << " ms, " << (allocations - before) / nRequests << " allocations per request" << endl;
+
+	tinyxml2::DocumentPool pool;
+	before = allocations;
+	ms = time_ms ([&]
+	{
+		for (size_t n = 0; n < nRequests; ++n)
+			found += !!pool .Load (request) -> RootElement();
+	});
+	cout << nRequests << " requests, DocumentPool " << ms << " ms, " << (allocations - before) / nRequests << " allocations per request" << endl;
+	return found == 2 * nRequests ? 0 : 1;
+}
@@ -0,0 +1,66 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_stats.cpp times selections with query statistics compiled in, untraced and traced for the query and by path,
+and shows the statistics gathered
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+
+// statistics are only counted when this is defined before including tixml2ex.h
+#define TIXML2EX_QUERY_STATS
+
+#include <string>
+#include <chrono>
+#include <iostream>
+
+#include <tixml2ex.h>
+#include "bench_generator.h"
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+int main()
+{
+	const DocumentShape shape {"deep", 10, 3, 2, 16};
+	auto doc = tinyxml2::load_document (generate_xml (shape));
+	const tinyxml2::XPath all {level_path (shape)};
+	const tinyxml2::XPath filtered {level_path (shape, "[@ix='1']")};
+	const tinyxml2::XPath descendants {"//"s + level_name (shape .depth) + "[@ix='1']"};
+
+	tinyxml2::QueryStats stats;
+	tinyxml2::QueryRegistry registry;
+	for (auto const & xpath : {all, filtered, descendants})
+	{
+		size_t n = 0;
+		auto untraced = time_ms (20, [&] { for (auto e : selection (*doc, xpath)) n += e != nullptr; });
+		auto traced = time_ms (20, [&] { for (auto e : selection (*doc, xpath) .Trace (stats)) n += e != nullptr; });
+		auto registered = time_ms (20, [&] { for (auto e : selection (*doc, xpath) .Trace (registry)) n += e != nullptr; });
+		cout << xpath_string (xpath) << endl
+			<< "   untraced " << untraced << " ms, traced " << traced << " ms, traced by path " << registered << " ms" << endl;
+	}
+	cout << endl << "one query: " << stats .queries << " queries, " << stats .visited << " visited, " << stats .skipped << " skipped by name, "
+		<< stats .predicates << " predicates, " << stats .failed << " failed, " << stats .matched << " matched" << endl;
+	cout << endl << "by path:" << endl << registry .Dump();
+	return 0;
+}
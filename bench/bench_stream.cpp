@@ -0,0 +1,97 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_stream.cpp times stream_selection on a large generated feed against loading the whole document and selecting from it
+usage: bench_stream [megabytes [document|stream]], run each way separately to compare peak memory
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+#include <string>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <cstdio>
+#ifndef _WIN32
+#include <sys/resource.h>
+#endif
+
+#include <tixml2fx.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+static string peak_memory()
+{
+#ifdef _WIN32
+	return "n/a"s;
+#else
+	rusage usage;
+	getrusage (RUSAGE_SELF, &usage);
+	return to_string (usage .ru_maxrss / 1024) + " MB"s;		// Linux reports kB
+#endif
+}
+
+
+int main (int argc, char * argv [])
+{
+	size_t megabytes = argc > 1 ? stoul (argv [1]) : 200;
+	string how = argc > 2 ? argv [2] : "both"s;
+	string path = "bench_stream.xml"s;
+	{
+		ofstream file (path, ios::binary);
+		file << "<Feed>\n";
+		string record;
+		for (size_t n = 0, size = 0; size < megabytes << 20; ++n, size += record .size())
+		{
+			record = "<Record id='"s + to_string (n) + "' type='"s + (n % 10 == 0 ? "x"s : "y"s) + "'><Name>record "s + to_string (n)
+					+ "</Name><Value>"s + to_string (n * 7) + "</Value></Record>\n"s;
+			file << record;
+		}
+		file << "</Feed>\n";
+	}
+	cout << megabytes << " MB feed, peak memory before selecting " << peak_memory() << endl;
+
+	const tinyxml2::XPath records {"Feed/Record[@type='x']"};
+	if (how != "stream"s)
+	{
+		size_t nSelected = 0;
+		auto ms = time_ms ([&]
+		{
+			auto doc = tinyxml2::load_document_file (path);
+			for (auto record : tinyxml2::selection (*doc, records))
+				nSelected += !!record -> FirstChildElement ("Value");
+		});
+		cout << "   document " << nSelected << " records " << ms << " ms, peak memory " << peak_memory() << endl;
+	}
+	if (how != "document"s)
+	{
+		size_t nSelected = 0;
+		auto ms = time_ms ([&]
+		{
+			tinyxml2::stream_selection (path, records, [&nSelected] (tinyxml2::XMLElement * record) { nSelected += !!record -> FirstChildElement ("Value"); });
+		});
+		cout << "   stream_selection " << nSelected << " records " << ms << " ms, peak memory " << peak_memory() << endl;
+	}
+	remove (path .c_str());
+	return 0;
+}
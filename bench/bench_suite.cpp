@@ -0,0 +1,190 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_suite.cpp times the main operations, parse, select, find, mutate, copy and template copy, on generated documents of several shapes
+reporting the time and the allocations made per operation, so that a change to any of them can be measured
+run with --quick for small documents, as a check that everything works
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+
+// counts allocations, replacing the global operator new and delete
+#define BENCH_COUNT_ALLOCATIONS
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <iomanip>
+
+#include <tixml2cx.h>
+#include "bench_generator.h"
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+static bool failed {false};
+
+
+// time repeat runs of op, each after an untimed prepare, and report the time and allocations per operation
+// op returns a count of what it did, reported from the last run so that runs can be checked against each other
+template <typename P, typename F> static void measure (const char * what, int repeat, P prepare, F op)
+{
+	chrono::steady_clock::duration elapsed {};
+	size_t allocated = 0;
+	size_t count = 0;
+	for (int r = 0; r < repeat; ++r)
+	{
+		prepare();
+		auto before = allocations .load();
+		auto start = chrono::steady_clock::now();
+		count = op();
+		elapsed += chrono::steady_clock::now() - start;
+		allocated += allocations - before;
+	}
+	auto us = chrono::duration<double, micro> (elapsed) .count() / repeat;
+	cout << "   " << left << setw (24) << what << right << setw (12) << fixed << setprecision (1) << us << " us"
+		<< setw (12) << allocated / repeat << " allocations" << setw (10) << count << endl;
+}
+
+template <typename F> static void measure (const char * what, int repeat, F op)
+{
+	measure (what, repeat, [] {}, op);
+}
+
+static void check (bool ok, const char * what)
+{
+	if (!ok)
+	{
+		cout << "**FAILED** " << what << endl;
+		failed = true;
+	}
+}
+
+
+static void run (const DocumentShape & shape, int repeat)
+{
+	auto xml = generate_xml (shape);
+	cout << shape .name << " : depth " << shape .depth << ", fan-out " << shape .fanOut << ", " << shape .attributes << " attributes, "
+		<< shape .textSize << " characters of text; " << shape .Elements() << " elements, " << xml .size() / 1024 << " KB" << endl;
+
+	// parse
+	measure ("parse", repeat, [&xml] { return tinyxml2::load_document (xml) -> RootElement() ? 1 : 0; });
+	auto doc = tinyxml2::load_document (xml);
+	auto root = doc -> RootElement();
+
+	// select
+	const tinyxml2::XPath all {level_path (shape)};
+	const tinyxml2::XPath first {level_path (shape, "[@ix='0']")};
+	const tinyxml2::XPath descendants {"//"s + level_name (shape .depth) + "[@ix='1']"};
+	auto count = [] (auto && elements) { size_t n = 0; for (auto e : elements) n += e != nullptr; return n; };
+	measure ("select", repeat, [&] { return count (tinyxml2::selection (*doc, all)); });
+	measure ("select, filtered", repeat, [&] { return count (tinyxml2::selection (*doc, first)); });
+	measure ("select, descendants", repeat, [&] { return count (tinyxml2::selection (*doc, descendants)); });
+	measure ("select, uncompiled", repeat, [&] { return count (tinyxml2::selection (*doc, level_path (shape, "[@ix='0']"))); });
+
+	// find, the last element at the bottom level is the furthest to search
+	const tinyxml2::XPath last {level_path (shape, "[@ix='"s + to_string (shape .fanOut - 1) + "']")};
+	measure ("find", repeat, [&] { return find_element (*doc, last) ? 1 : 0; });
+	check (find_element (*doc, last) && attribute_value (find_element (*doc, last), "id") == to_string (shape .Elements()), "find_element found the wrong element");
+
+	// mutate, a branch is appended to each element of the first level and then a sibling inserted after it
+	unique_ptr<tinyxml2::XMLDocument> copy;
+	auto fresh = [&] { copy = tinyxml2::load_document (xml); };
+	measure ("append_element", repeat, fresh, [&]
+	{
+		size_t n = 0;
+		for (auto e = copy -> RootElement() -> FirstChildElement(); e; e = e -> NextSiblingElement())
+			n += append_element (e, "m/n[@k='v']", {{"id"s, "x"s}}, "text"s) != nullptr;
+		return n;
+	});
+	measure ("insert_next_element", repeat, fresh, [&]
+	{
+		size_t n = 0;
+		for (auto e = copy -> RootElement() -> FirstChildElement(); e; e = e -> NextSiblingElement())
+			n += (e = insert_next_element (e, "s", {{"id"s, "x"s}}, "text"s)) != nullptr;
+		return n;
+	});
+
+	// copy, into a document cleared each time so that its memory is reused
+	tinyxml2::XMLDocument dest;
+	auto destRoot = dest .NewElement ("copy");
+	dest .InsertEndChild (destRoot);
+	auto clear = [&] { destRoot -> DeleteChildren(); };
+	measure ("xcopy", repeat, clear, [&] { xcopy (root, destRoot); return (size_t) 1; });
+	measure ("xcopy, filtered", repeat, clear, [&]
+	{
+		xcopy (root, destRoot, [] (const tinyxml2::XMLElement * e) { return !e -> Attribute ("ix", "0") || !e -> FirstChildElement(); });
+		return (size_t) 1;
+	});
+
+	// template copy, of the same shape with parameters in attribute values and text
+	auto templateShape = shape;
+	templateShape .parameters = true;
+	auto templates = tinyxml2::load_document (generate_xml (templateShape));
+	const unordered_map<string, string> params {{"p0", "zero"}, {"p1", "one"}, {"p2", "two"}};
+	measure ("xcopy, parameters", repeat, clear, [&] { xcopy (templates -> RootElement(), destRoot, params); return (size_t) 1; });
+	const tinyxml2::CompiledTemplate compiled (templates -> RootElement());
+	measure ("CompiledTemplate", repeat, clear, [&] { return xcopy (compiled, destRoot, params) ? 1 : 0; });
+
+	clear();
+	xcopy (templates -> RootElement(), destRoot, params);
+	tinyxml2::XMLPrinter substituted;
+	dest .Print (&substituted);
+	clear();
+	xcopy (compiled, destRoot, params);
+	tinyxml2::XMLPrinter instantiated;
+	dest .Print (&instantiated);
+	check (strcmp (substituted .CStr(), instantiated .CStr()) == 0, "CompiledTemplate differs from xcopy with parameters");
+	check (strstr (substituted .CStr(), "{p") == nullptr, "parameter left in template copy");
+	cout << endl;
+}
+
+
+int main (int argc, char * argv [])
+{
+	bool quick = argc > 1 && strcmp (argv [1], "--quick") == 0;
+
+	//                        name          depth fan-out attributes text
+	vector<DocumentShape> shapes
+	{
+		{"deep",        10,   3,  2,  16},
+		{"wide",         2, 300,  2,  16},
+		{"attributes",   4,  16, 12,   0},
+		{"text",         3,  40,  1, 512},
+	};
+	if (quick)
+	{
+		for (auto & shape : shapes)
+		{
+			shape .depth = min (shape .depth, 4);
+			shape .fanOut = min (shape .fanOut, 6);
+		}
+	}
+	cout << "   " << left << setw (24) << "operation" << right << setw (15) << "time/op" << setw (24) << "allocations/op" << setw (10) << "count" << endl << endl;
+	for (auto const & shape : shapes)
+		run (shape, quick ? 2 : 10);
+	return failed ? 1 : 0;
+}
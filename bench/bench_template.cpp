@@ -0,0 +1,104 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_template.cpp times instantiating a template many times with xcopy and parameters, with a CompiledTemplate
+and with a CompiledTemplate into documents on a pool of threads, counting the allocations made
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+// counts allocations, replacing the global operator new and delete
+#define BENCH_COUNT_ALLOCATIONS
+
+#include <string>
+#include <chrono>
+#include <atomic>
+#include <iostream>
+
+#include <tixml2cx.h>
+#include <tixml2px.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+template <typename F> static void time_instances (const char * how, size_t nInstances, F instantiate)
+{
+	auto before = allocations .load();
+	auto start = chrono::steady_clock::now();
+	instantiate();
+	auto ms = chrono::duration<double, milli> (chrono::steady_clock::now() - start) .count();
+	cout << "   " << how << " " << ms << " ms, " << (allocations - before) / nInstances << " allocations per instance" << endl;
+}
+
+
+int main (int argc, char * argv [])
+{
+	size_t nInstances = argc > 1 ? stoul (argv [1]) : 20000;
+	auto source = tinyxml2::load_document (R"-(
+		<Order id="{id}" currency="GBP" channel="web">
+			<Customer ref="{customer}" type="retail"><Name>{name}</Name><Address country="UK">12 High Street, {town}</Address></Customer>
+			<Line sku="{sku}" qty="{qty}" price="9.99"/>
+			<Line sku="A-100" qty="1" price="0.00"><Note>free gift for order {id}</Note></Line>
+			<!-- generated -->
+			<Terms><![CDATA[standard terms {not substituted}]]></Terms>
+		</Order>)-"s);
+	const unordered_map<string, string> params {{"id", "10045"}, {"customer", "C-0091"}, {"name", "A. Customer"}, {"town", "Exeter"}, {"sku", "B-220"}, {"qty", "3"}};
+	cout << nInstances << " instances" << endl;
+
+	auto destination = make_unique<tinyxml2::XMLDocument>();
+	auto parent = destination -> NewElement ("Orders");
+	destination -> InsertEndChild (parent);
+	time_instances ("xcopy with parameters", nInstances, [&]
+	{
+		for (size_t n = 0; n < nInstances; ++n)
+			xcopy (source -> RootElement(), parent, params);
+	});
+
+	destination = make_unique<tinyxml2::XMLDocument>();
+	parent = destination -> NewElement ("Orders");
+	destination -> InsertEndChild (parent);
+	const tinyxml2::CompiledTemplate order (source -> RootElement());
+	time_instances ("CompiledTemplate", nInstances, [&]
+	{
+		for (size_t n = 0; n < nInstances; ++n)
+			xcopy (order, parent, params);
+	});
+
+	// a document per task, the template is shared
+	tinyxml2::ThreadPool pool;
+	vector<unique_ptr<tinyxml2::XMLDocument>> documents;
+	vector<function<void()>> tasks;
+	auto nTasks = (pool .Size() + 1) * 4;
+	for (size_t ixTask = 0; ixTask < nTasks; ++ixTask)
+	{
+		documents .push_back (make_unique<tinyxml2::XMLDocument>());
+		auto orders = documents .back() -> NewElement ("Orders");
+		documents .back() -> InsertEndChild (orders);
+		tasks .push_back ([&, orders, n = nInstances * (ixTask + 1) / nTasks - nInstances * ixTask / nTasks]
+		{
+			for (size_t ix = 0; ix < n; ++ix)
+				xcopy (order, orders, params);
+		});
+	}
+	time_instances ("CompiledTemplate, in parallel", nInstances, [&] { pool .Run (move (tasks)); });
+	return 0;
+}
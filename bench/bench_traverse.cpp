@@ -0,0 +1,143 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_traverse.cpp compares the iterative selection walk of ElementIterator with the recursive walk it replaced
+on deep and on wide synthetic documents
+
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <iostream>
+
+#include <tixml2ex.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+// the recursive descend / traverse walk used by ElementIterator before the explicit cursor stack
+class RecursiveWalk
+{
+public:
+	RecursiveWalk (const tinyxml2::XMLElement * origin, const tinyxml2::XPath & xpath) : _xpath (xpath), _branch (xpath .Size(), nullptr)
+	{
+		descend (0, origin);
+	}
+	const tinyxml2::XMLElement * operator *() const { return _branch .back(); }
+	void operator ++() { traverse (_branch .size() - 1); }
+
+private:
+	bool descend (size_t level, const tinyxml2::XMLElement * parent)
+	{
+		if (!parent)
+			return false;
+		if (level == _branch .size())
+			return true;
+		for (_branch [level] = parent -> FirstChildElement (name (level)); _branch [level]; _branch [level] = _branch [level] -> NextSiblingElement (name (level)))
+		{
+			if (_xpath .Match (level, _branch [level]) && descend (level + 1, _branch [level]))
+				return true;
+		}
+		return false;
+	}
+	void traverse (size_t level)
+	{
+		while ((_branch [level] = _branch [level] -> NextSiblingElement (name (level))))
+		{
+			if (_xpath .Match (level, _branch [level]) && descend (level + 1, _branch [level]))
+				return;
+		}
+		if (level > 0)
+			traverse (level - 1);
+	}
+	const char * name (size_t level) const { return *_xpath .Name (level) ? _xpath .Name (level) : nullptr; }
+
+	tinyxml2::XPath _xpath;
+	vector<const tinyxml2::XMLElement *> _branch;
+};
+
+
+// every element has fanOut children named "e", the last of each carrying attribute last='1', down to depth
+static void grow (tinyxml2::XMLElement * parent, int depth, int fanOut)
+{
+	if (depth == 0)
+		return;
+	for (int n = 0; n < fanOut; ++n)
+	{
+		auto e = parent -> GetDocument() -> NewElement ("e");
+		if (n == fanOut - 1)
+			e -> SetAttribute ("last", 1);
+		parent -> InsertEndChild (e);
+		grow (e, depth - 1, fanOut);
+	}
+}
+
+
+static void compare (const string & title, int depth, int fanOut, const string & xpath, int repeat)
+{
+	tinyxml2::XMLDocument doc;
+	auto root = doc .NewElement ("root");
+	doc .InsertEndChild (root);
+	grow (root, depth, fanOut);
+	const tinyxml2::XPath compiled {xpath};
+
+	size_t nIterative = 0, nRecursive = 0;
+	auto iterative = time_ms (repeat, [&]
+	{
+		nIterative = 0;
+		for (auto e : tinyxml2::selection (static_cast<const tinyxml2::XMLElement *> (root), compiled))
+			nIterative += e != nullptr;
+	});
+	auto recursive = time_ms (repeat, [&]
+	{
+		nRecursive = 0;
+		for (RecursiveWalk walk (root, compiled); *walk; ++walk)
+			++nRecursive;
+	});
+
+	cout << title << " depth " << depth << " fan-out " << fanOut << " : " << nIterative << " matches" << endl
+		<< "   iterative " << iterative << " ms, recursive " << recursive << " ms, speed-up x" << recursive / iterative << endl;
+	if (nIterative != nRecursive)
+		cout << "**FAILED** recursive walk found " << nRecursive << " matches" << endl;
+}
+
+
+int main()
+{
+	string deep, deepLast, deepNone;
+	for (int level = 0; level < 18; ++level)
+	{
+		deep += (level ? "/"s : ""s) + "e";
+		deepLast += (level ? "/"s : ""s) + "e[@last]";
+	}
+	deepNone = deep + "[@none]";
+	compare ("deep, every branch", 18, 2, deep, 5);
+	compare ("deep, no branch matches", 18, 2, deepNone, 5);
+	compare ("deep, last branch only", 18, 2, deepLast, 10000);
+	compare ("wide", 2, 1000, "e/e", 5);
+	compare ("wide, sparse matches", 2, 1000, "e/e[@last]", 5);
+	compare ("bushy", 6, 8, "e/e/e/e/e/e", 5);
+	return 0;
+}
@@ -0,0 +1,114 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+bench_writer.cpp times writing a large export with XmlWriter against building it with append_elements and printing it,
+measuring the most memory held at once by each
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+
+// keeps the memory in use, replacing the global operator new and delete
+#define BENCH_COUNT_ALLOCATIONS
+
+#include <string>
+#include <array>
+#include <utility>
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <fcntl.h>
+
+#include <tixml2ex.h>
+#include <tixml2wx.h>
+#include "bench.h"
+
+using namespace std;
+using namespace std::literals::string_literals;
+
+
+// rows are made as they are written, so that only the export itself can hold memory
+struct Rows
+{
+	struct Row
+	{
+		string id;
+		string name;
+		string amount;
+	};
+	struct iterator
+	{
+		size_t n;
+		Row operator * () const { return Row {to_string (n), "row "s + to_string (n), to_string (n * 7)}; }
+		iterator & operator ++ () { ++n; return *this; }
+		bool operator != (const iterator & other) const { return n != other .n; }
+	};
+	iterator begin() const { return {0}; }
+	iterator end() const { return {nRows}; }
+	size_t nRows;
+};
+
+
+template <typename F> static void time_export (const char * how, F write)
+{
+	peak = inUse .load();
+	auto before = inUse .load();
+	auto start = chrono::steady_clock::now();
+	write();
+	auto ms = chrono::duration<double, milli> (chrono::steady_clock::now() - start) .count();
+	cout << "   " << how << " " << ms << " ms, at most " << (peak - before) / 1024 << " KB held" << endl;
+}
+
+
+int main (int argc, char * argv [])
+{
+	Rows rows {argc > 1 ? stoul (argv [1]) : 1000000};
+	const char * out = argc > 2 ? argv [2] : "/dev/null";
+	cout << rows .nRows << " rows to " << out << endl;
+
+	const tinyxml2::XPath rowPath {"Row[@type='r']"};
+	auto attributes = [] (const Rows::Row & row)
+	{
+		return array<pair<const char *, const char *>, 3> {{{"id", row .id .c_str()}, {"name", row .name .c_str()}, {"amount", row .amount .c_str()}}};
+	};
+
+	time_export ("append_elements and XMLPrinter", [&]
+	{
+		tinyxml2::XMLDocument doc;
+		auto parent = doc .NewElement ("Export");
+		doc .InsertEndChild (parent);
+		append_elements (parent, rowPath, rows, attributes);
+		auto file = fopen (out, "wb");
+		tinyxml2::XMLPrinter printer (file);
+		doc .Print (&printer);
+		fclose (file);
+	});
+
+	time_export ("XmlWriter", [&]
+	{
+		auto fd = open (out, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+		{
+			tinyxml2::XmlWriter writer (fd);
+			writer .Open ("Export");
+			write_elements (writer, rowPath, rows, attributes);
+		}
+		close (fd);
+	});
+	return 0;
+}
@@ -24,17 +24,47 @@ It can be found here: https://github.com/leethomason/tinyxml2 and has it's own l
 
 #include <string>
 #include <iostream>
+#include <fstream>
 #include <algorithm>
+#include <optional>
+#include <cstdlib>
+#include <new>
 #include <conio.h>
 
 
+// count what selections do, see Trace(), the counting is compiled out unless this is defined
+#define TIXML2EX_QUERY_STATS
 // include the header for tinyxml2ex which includes tinyxml2, remember to put them on your include path
 #include <tixml2cx.h>
+// parallel operations are separate, they use the thread library
+#include <tixml2px.h>
+// so is writing XML without a document
+#include <tixml2wx.h>
 
 using namespace std;
 using namespace std::literals::string_literals;
 
 
+// count heap allocations so that we can show which operations allocate
+static size_t allocations {0};
+
+static void * counted_allocate (size_t size)
+{
+	++allocations;
+	if (auto p = malloc (size ? size : 1))
+		return p;
+	throw bad_alloc();
+}
+
+// the array forms too, so that every block from malloc is released with free
+void * operator new (size_t size) { return counted_allocate (size); }
+void * operator new [] (size_t size) { return counted_allocate (size); }
+void operator delete (void * p) noexcept { free (p); }
+void operator delete [] (void * p) noexcept { free (p); }
+void operator delete (void * p, size_t) noexcept { free (p); }
+void operator delete [] (void * p, size_t) noexcept { free (p); }
+
+
 int main()
 {
 	// a simple XML document
@@ -225,6 +255,122 @@ int main()
 		cout << "=================================================" << endl << endl;
 
 
+		// view text and attribute values in place, without copying them into strings
+		cout << "view code attribute and text of <C> children of selected <B>" << endl;
+		for (auto cc : tinyxml2::selection (bThree, "C"))
+			cout << attribute_view (cc, "code") << " : " << text_view (cc) << endl;
+		cout << "=================================================" << endl << endl;
+
+
+		// convert attribute values to numbers directly, code is optional and only some codes are decimal
+		cout << "decimal codes of <C> children of selected <B>" << endl;
+		for (auto cc : tinyxml2::selection (bThree, "C"))
+		{
+			try
+			{
+				if (auto code = tinyxml2::attribute_as<optional<int>> (cc, "code"))
+					cout << *code << " + 1 = " << *code + 1 << endl;
+			}
+			catch (tinyxml2::XmlException & e)
+			{
+				cout << attribute_view (cc, "code") << " : " << e .what() << endl;
+			}
+		}
+		cout << "=================================================" << endl << endl;
+
+
+		// compile an XPath once and reuse it for any number of selections, on this or any other document
+		cout << "reuse compiled XPath A/B[@id]/D" << endl;
+		const tinyxml2::XPath dOfB {"A/B[@id]/D"s};
+		for (auto dd : tinyxml2::selection (*doc, dOfB))
+			cout << dd -> Name() << " id=" << attribute_value (dd, "id") << endl;
+		if (auto dd = find_element (*doc, dOfB))
+			cout << "first is " << attribute_value (dd, "id") << endl;
+		cout << "=================================================" << endl << endl;
+
+
+		// or parse the XPath at compile time, a malformed path will not compile
+		cout << "compile-time XPath A/B[@id='three']/C" << endl;
+		static constexpr tinyxml2::XPathLiteral cOfB3 {"A/B[@id='three']/C"};
+		for (auto cc : tinyxml2::selection (*doc, cOfB3))
+			cout << cc -> Name() << " code=" << attribute_value (cc, "code") << endl;
+		cout << "=================================================" << endl << endl;
+
+
+		// intern element names so that selections compare names by pointer
+		cout << "interned names A/B/C" << endl;
+		tinyxml2::NameTable names (*doc);
+		for (auto cc : tinyxml2::selection (*doc, tinyxml2::XPath {"A/B/C"s}, names))
+			cout << cc -> Name() << " code=" << attribute_value (cc, "code") << endl;
+		cout << "=================================================" << endl << endl;
+
+
+		// index the document by element name, lookups then visit only elements with the name of the last step
+		cout << "indexed A/B[@id='three']/C" << endl;
+		tinyxml2::DocumentIndex index (*doc);
+		for (auto cc : tinyxml2::selection (*doc, tinyxml2::XPath {"A/B[@id='three']/C"s}, index))
+			cout << cc -> Name() << " code=" << attribute_value (cc, "code") << endl;
+		// an index is for the document it was built over, selecting from another document with it throws
+		try
+		{
+			auto other = tinyxml2::load_document ("<A><B id='three'><C/></B></A>");
+			find_element (*other, tinyxml2::XPath {"A/B[@id='three']/C"s}, index);
+		}
+		catch (tinyxml2::XmlException & e)
+		{
+			cout << "another document : " << e .what() << endl;
+		}
+		cout << "=================================================" << endl << endl;
+
+		// declare a hash index on <B id=...>, keyed lookups given the index then go straight to the element
+		cout << "keyed A/B[@id='three']" << endl;
+		{
+			tinyxml2::AttributeIndex keys (*doc);
+			keys .Declare ("B"s, "id"s);
+			if (auto bb = find_element (*doc, tinyxml2::XPath {"A/B[@id='three']"s}, keys))
+				cout << bb -> Name() << " id=" << attribute_value (bb, "id") << endl;
+		}
+		cout << "=================================================" << endl << endl;
+
+
+		// select descendants at any depth
+		cout << "descendants //C[@code='1234']" << endl;
+		for (auto cc : selection (*doc, "//C[@code='1234']"))
+			cout << cc -> Name() << " code=" << attribute_value (cc, "code") << " in " << cc -> Parent() -> ToElement() -> Name() << endl;
+		cout << "=================================================" << endl << endl;
+
+
+		// select by position, and a window of the matches
+		cout << "second <C> of each <B>, last <B>, then <C> elements 2 and 3" << endl;
+		for (auto cc : selection (*doc, "A/B/C[2]"))
+			cout << cc -> Name() << " code=" << attribute_value (cc, "code") << endl;
+		if (auto bb = find_element (*doc, "A/B[last()]"))
+			cout << bb -> Name() << " id=" << attribute_value (bb, "id") << endl;
+		for (auto cc : selection (*doc, "A/B/C") .Offset (1) .Limit (2))
+			cout << cc -> Name() << " code=" << attribute_value (cc, "code") << endl;
+		cout << "=================================================" << endl << endl;
+
+
+		// work on the <C> elements of each <B> concurrently, the <B> elements being independent subtrees
+		cout << "count <C> elements in parallel, split at A/B" << endl;
+		atomic<int> nParallel {0};
+		parallel_for_each (selection (*doc, "A/B/C"), [&nParallel] (const tinyxml2::XMLElement *) { ++nParallel; }, 1);
+		cout << nParallel << " <C> elements" << endl;
+		cout << "=================================================" << endl << endl;
+
+
+		// load a batch of documents concurrently, a document in error doesn't stop the others
+		cout << "load a batch of documents, in order, with at most two in flight" << endl;
+		tinyxml2::load_documents (vector<string> {testXml, "<A><B></A>"s, "<Z/>"s}, [] (size_t ix, tinyxml2::LoadResult && result)
+		{
+			if (result)
+				cout << ix << " : " << result .document -> RootElement() -> Name() << endl;
+			else
+				cout << ix << " : error " << result .error << " at line " << result .line << ", " << result .message << endl;
+		}, tinyxml2::shared_pool(), 2);
+		cout << "=================================================" << endl << endl;
+
+
 		// iterate over all children, any name (type), of <B> elements which are children of the document element
 		cout << "iterate over all children, any name (type), of <B> elements which are children of the document element" << endl;
 		auto eA = doc -> FirstChildElement();
@@ -238,6 +384,57 @@ int main()
 	}
 
 
+	/////////////////////// load from file
+
+
+	try
+	{
+		ofstream ("test.xml") << testXml;
+		auto doc = tinyxml2::load_document_file ("test.xml");
+		cout << "loaded " << doc -> RootElement() -> Name() << " from test.xml" << endl;
+		// parse only as far as the first match
+		if (auto first = tinyxml2::find_first_in_buffer (testXml, tinyxml2::XPath {"A/B[@id='one']"}))
+			cout << "first " << first -> RootElement() -> Name() << " id=" << attribute_value (first -> RootElement(), "id") << endl;
+		// select from the file without loading all of it, each <C> arrives in a document of its own
+		tinyxml2::stream_selection ("test.xml", tinyxml2::XPath {"A/B/C[@code='1234']"}, [] (tinyxml2::XMLElement * cc)
+		{
+			cout << "streamed " << cc -> Name() << " code=" << attribute_value (cc, "code") << " : " << text (cc) << endl;
+		});
+		ofstream ("test.xml") << "<A>\n   <B>\n</A>\n";
+		doc = tinyxml2::load_document_file ("test.xml");
+	}
+	catch (tinyxml2::XmlParseError & e)
+	{
+		cout << e .what() << ", line " << e .Line() << " starts at offset " << e .Offset() << endl;
+	}
+	catch (tinyxml2::XmlException & e)
+	{
+		cout << e .what() << endl;
+	}
+	remove ("test.xml");
+
+
+	/////////////////////// reuse documents
+
+
+	try
+	{
+		// each document goes back to the pool when released, keeping tinyxml2's memory for the next parse
+		tinyxml2::DocumentPool pool (2);
+		string_view requests [] {"<Request id='1'/>", "<Request id='2'/>", "<Request id='3'/>trailing text not passed to the parser"};
+		for (auto request : requests)
+		{
+			auto doc = pool .Load (request .substr (0, request .find ('>') + 1));
+			cout << "request " << attribute_value (doc -> RootElement(), "id") << endl;
+		}
+		cout << pool .Idle() << " idle document, used for all three requests" << endl;
+	}
+	catch (tinyxml2::XmlException & e)
+	{
+		cout << e .what() << endl;
+	}
+
+
 	/////////////////////// modify the document
 
 
@@ -251,6 +448,12 @@ int main()
 		auto czCode {"ZXCV"s};
 		auto czData {"corneto"s};
 		insert_next_element  (ne, "CZ", {{"id"s, czId}, {"code"s, czCode}}, czData);
+		// and append a batch of elements from records
+		vector<pair<string, string>> rows {{"1", "one"}, {"2", "two"}, {"3", "three"}};
+		append_elements (find_element (*doc, "A/B[@id='two']"s), tinyxml2::XPath {"CR[@type='row']"}, rows, [] (const pair<string, string> & row)
+		{
+			return tinyxml2::attribute_list_t {{"id"s, row .first}, {"name"s, row .second}};
+		});
 
 		// todo:
 		// what do we want find_element to do when path is empty?
@@ -276,6 +479,12 @@ int main()
 		dest -> InsertEndChild (e);
 
 		xcopy (source -> FirstChildElement(), e, {{"extern", "internal"}, {"B4", "Bee Four"}});
+		// compile a template once to copy it many times
+		const tinyxml2::CompiledTemplate bTemplate (find_element (*source, "A/B[@org]"));
+		for (auto org : {"north"s, "south"s})
+			xcopy (bTemplate, e, {{"extern", org}});
+		// and again, leaving out the <D> elements
+		xcopy (source -> FirstChildElement(), e, [] (const tinyxml2::XMLElement * element) { return strcmp (element -> Name(), "D") != 0; });
 
 		tinyxml2::XMLPrinter printer;
 		dest -> Print (&printer);
@@ -287,6 +496,128 @@ int main()
 	}
 
 
+	/////////////////////// write without a document
+	try
+	{
+		auto source = tinyxml2::load_document (testXml);
+		string out;
+		{
+			tinyxml2::XmlWriter writer (out);
+			writer .Declaration();
+			writer .Open ("/Export[@from='A']");
+			vector<pair<string, string>> rows {{"1", "one & only"}, {"2", "<two>"}};
+			write_elements (writer, tinyxml2::XPath {"Rows/Row"}, rows, [] (const pair<string, string> & row, tinyxml2::XmlWriter & writer)
+			{
+				writer .Attribute ("id", row .first) .Text (row .second);
+			});
+			// an element from a document goes into the stream as it is
+			writer .Splice (find_element (*source, "A/B[@id='two']"s));
+		}	// closes <Export>
+		cout << out << endl;
+
+		// the output is the same as building the document and printing it
+		tinyxml2::XMLDocument built;
+		built .InsertEndChild (built .NewDeclaration());
+		auto e = built .NewElement ("Export");
+		e -> SetAttribute ("from", "A");
+		built .InsertEndChild (e);
+		append_element (e, "Rows/Row", {{"id"s, "1"s}}, "one & only"s);
+		append_element (e, "Rows/Row", {{"id"s, "2"s}}, "<two>"s);
+		xcopy (find_element (*source, "A/B[@id='two']"s), e);
+		tinyxml2::XMLPrinter printer;
+		built .Print (&printer);
+		if (out != printer .CStr())
+			cout << "**FAILED** XmlWriter output differs from printed document" << endl;
+	}
+	catch (tinyxml2::XmlException & e)
+	{
+		cout << e .what() << endl;
+	}
+
+
+
+	/////////////////////// query statistics
+	try
+	{
+		auto doc = tinyxml2::load_document (testXml);
+		tinyxml2::QueryStats stats;
+		size_t nC = 0;
+		for (auto c : selection (*doc, "A/B/C[@code='9ABC']"s) .Trace (stats))
+			nC += c != nullptr;
+		cout << nC << " <C code='9ABC'> elements, " << stats .visited << " elements visited, " << stats .skipped << " skipped by name, "
+			<< stats .predicates << " predicates checked, " << stats .failed << " failed" << endl;
+
+		// trace every selection, by path
+		tinyxml2::QueryRegistry::Global() .Enable();
+		for (auto id : {"one"s, "two"s, "three"s})
+			find_element (*doc, "A/B[@id='"s + id + "']/C"s);
+		for (auto b : selection (*doc, "//B"s))
+			(void) b;
+		tinyxml2::QueryRegistry::Global() .Enable (false);
+		cout << tinyxml2::QueryRegistry::Global() .Dump();
+	}
+	catch (tinyxml2::XmlException & e)
+	{
+		cout << e .what() << endl;
+	}
+
+
+
+	/////////////////////// selection cache
+	try
+	{
+		auto doc = tinyxml2::load_document (testXml);
+		tinyxml2::SelectionCache cache (*doc);
+		const tinyxml2::XPath cOfB {"A/B/C"s};
+		for (int n = 0; n < 3; ++n)
+			cout << cache .Select (cOfB) -> size() << " <C> elements, ";
+		// changes made through the extensions start a new generation, so the selection is made again
+		append_element (find_element (*doc, "A/B[@id='two']"s), "C[@code='0000']");
+		cout << cache .Select (cOfB) -> size() << " <C> elements after appending one" << endl;
+		cout << cache .Hits() << " hits, " << cache .Misses() << " misses, generation " << cache .Generation() << endl;
+	}
+	catch (tinyxml2::XmlException & e)
+	{
+		cout << e .what() << endl;
+	}
+
+
+
+	/////////////////////// allocation-free selection
+	// once an XPath is compiled, selecting, iterating, copying and comparing iterators do not allocate
+	try
+	{
+		auto doc = tinyxml2::load_document (testXml);
+		const tinyxml2::XPath cOfB {"A/B/C"s};
+		const tinyxml2::XPath deep {"A/B/C/D/E/F/G/H/I/J"s};	// deeper than the iterator holds locally
+
+		auto before = allocations;
+		size_t nC = 0;
+		auto cc = tinyxml2::selection (*doc, cOfB);
+		for (auto it = cc .begin(), last = cc .end(); it != last; ++it)
+		{
+			auto copy = it;
+			if (copy == it)
+				++nC;
+		}
+		auto first = find_element (*doc, cOfB);
+		auto count = allocations - before;
+		cout << nC << " <C> elements selected, first " << attribute_value (first, "code") << ", with " << count << " allocations" << endl;
+		if (count != 0)
+			cout << "**FAILED** selection with compiled XPath allocated" << endl;
+
+		before = allocations;
+		auto dd = tinyxml2::selection (*doc, deep);
+		auto none = dd .begin() == dd .end();
+		cout << "deep selection " << (none ? "empty" : "not empty") << ", with " << allocations - before << " allocations" << endl;
+	}
+	catch (tinyxml2::XmlException & e)
+	{
+		cout << e .what() << endl;
+	}
+	cout << "=================================================" << endl << endl;
+
+
 
 	// hold console window open so we can see the output
 	std::cout << "hit any key to close" << std::endl;
@@ -28,7 +28,11 @@ It can be found here: https://github.com/leethomason/tinyxml2 and has it's own l
 
 #pragma once
 
+#include <string>
+#include <string_view>
 #include <unordered_map>
+#include <type_traits>
+#include <vector>
 #ifndef __TINYXML_EX__
 #include <tixml2ex.h>
 #endif // !__TINYXML_EX__
@@ -88,11 +92,41 @@ namespace tinyxml2
 		};	// XMLCopy
 
 
+		// scan value for parameters between open and close delimiters, passing the text around them to literal and their names to parameter
+		// returns false, having passed nothing, if value has no parameters
+		template <typename L, typename P>
+		inline bool scan_parameters (std::string_view value, std::string_view open, std::string_view close, L literal, P parameter)
+		{
+			bool found = false;
+			size_t cursor = 0;
+			for (auto ps = value.find (open); ps != std::string_view::npos; ps = value.find (open, cursor))
+			{
+				auto pe = value.find (close, ps + open.size());
+				if (pe == std::string_view::npos)
+					break;	// an unclosed delimiter is left as it is
+				literal (value.substr (cursor, ps - cursor));
+				parameter (value.substr (ps + open.size(), pe - ps - open.size()));
+				cursor = pe + close.size();
+				found = true;
+			}
+			if (found)
+				literal (value.substr (cursor));
+			return found;
+		}
+
+
 		class XMLCopyAndReplace : public XMLCopy
 		{
 		public:
 			XMLCopyAndReplace (XMLElement * target, const std::unordered_map<std::string, std::string> & params, char openDelim, char closeDelim)
-				: XMLCopy(target), _params(params), _openDelim(openDelim), _closeDelim(closeDelim) {}
+				: XMLCopy(target), _params(params), _openDelim(1, openDelim), _closeDelim(1, closeDelim) {}
+			// delimiters of any length, such as ${ and }
+			XMLCopyAndReplace (XMLElement * target, const std::unordered_map<std::string, std::string> & params, std::string_view openDelim, std::string_view closeDelim)
+				: XMLCopy(target), _params(params), _openDelim(openDelim), _closeDelim(closeDelim)
+			{
+				if (_openDelim.empty() || _closeDelim.empty())
+					throw XmlException ("empty parameter delimiter"s);
+			}
 
 			bool VisitEnter (const XMLElement & element, const XMLAttribute * attribute) override
 			{
@@ -101,9 +135,8 @@ namespace tinyxml2
 					auto a = const_cast <XMLAttribute *> (_target->FirstAttribute());
 					while (a)
 					{
-						auto subst = substitute (a->Value());
-						if (subst.first)
-							a->SetAttribute (subst.second.c_str());
+						if (substitute (a->Value()))
+							a->SetAttribute (_value.c_str());
 						a = const_cast <XMLAttribute *> (a->Next());
 					}
 					return true;
@@ -119,9 +152,8 @@ namespace tinyxml2
 					auto t = _target->LastChild()->ToText();	// it's the element text 'cos that the last one we added
 					if (!t->CData())	// we don't substitute CDATA
 					{
-						auto subst = substitute (t->Value());
-						if (subst.first)
-							t->SetValue (subst.second.c_str());
+						if (substitute (t->Value()))
+							t->SetValue (_value.c_str());
 					}
 					return true;
 				}
@@ -130,53 +162,97 @@ namespace tinyxml2
 			}
 
 		private:
-			std::pair <bool, std::string> substitute (const std::string & val)
+			// substitute parameters in val into _value, false if val has none
+			// the pieces of the new value are collected first, so that it is built in one go in a buffer reused for every value
+			bool substitute (std::string_view val)
 			{
-				bool substituted{ false };
-				std::string newValue;
-				std::string::size_type cursor = 0;
-				auto ps = val.find (_openDelim);
-				while (ps != std::string::npos)
+				_pieces.clear();
+				auto literal = [this] (std::string_view text) { _pieces.push_back (text); };
+				auto parameter = [this] (std::string_view name)
 				{
-					newValue += val.substr (cursor, ps - cursor);
-					auto pe = val.find (_closeDelim, ps);
-					if (pe != std::string::npos)
-					{
-						cursor = pe + 1;
-						auto px = _params.find (val.substr (ps + 1, pe - ps - 1));
-						if (px != _params.end())
-						{
-							newValue += px->second;
-						}
-						else
-							throw XmlException ("no value for parameter " + (val.substr (ps + 1, pe - ps - 1)));
-						substituted = true;
-						ps = val.find (_openDelim, pe);
-					}
-					else
-					{
-						ps = std::string::npos;
-						break;
-					}
-				}
-				if (substituted)
-					return std::make_pair (true, newValue + val.substr (cursor, ps - cursor));
-				else
-					return std::make_pair (false, val);
+					_key.assign (name);
+					auto px = _params.find (_key);
+					if (px == _params.end())
+						throw XmlException ("no value for parameter " + _key);
+					_pieces.push_back (px->second);
+				};
+				if (!scan_parameters (val, _openDelim, _closeDelim, literal, parameter))
+					return false;
+				size_t size = 0;
+				for (auto piece : _pieces)
+					size += piece.size();
+				_value.clear();
+				_value.reserve (size);
+				for (auto piece : _pieces)
+					_value.append (piece);
+				return true;
 			}
 
 		private:
 			const std::unordered_map<std::string, std::string> & _params;
-			const char _openDelim;
-			const char _closeDelim;
+			const std::string _openDelim;
+			const std::string _closeDelim;
+			// reused for each value
+			std::vector<std::string_view> _pieces;
+			std::string _key;
+			std::string _value;
 
 		};	// XMLCopyAndReplace
 
 
+		// clone source into doc in a single pass, leaving out the subtree of each element for which keep returns false
+		// unknown nodes, such as <!DOCTYPE ...>, are left out, as XMLCopy and CompiledTemplate leave them out
+		template <typename F>
+		inline XMLElement * clone_element (const XMLElement * source, XMLDocument * doc, F keep)
+		{
+			if (!keep (source))
+				return nullptr;
+			auto root = source->ShallowClone (doc)->ToElement();
+			XMLNode * parent = root;	// clone of the parent of node
+			for (auto node = source->FirstChild(); node; )
+			{
+				auto element = node->ToElement();
+				if (element ? keep (element) : !node->ToUnknown())
+				{
+					auto clone = parent->InsertEndChild (node->ShallowClone (doc));
+					if (node->FirstChild())
+					{
+						parent = clone;
+						node = node->FirstChild();
+						continue;
+					}
+				}
+				for (; node != source && !node->NextSibling(); node = node->Parent())
+					parent = parent->Parent();
+				node = node != source ? node->NextSibling() : nullptr;
+			}
+			return root;
+		}
+
+
 		inline void xcopy (const XMLElement * source, XMLElement * destinationParent)
 		{
-			XMLCopy copier (destinationParent);
-			source->Accept (&copier);
+			// cloned directly, node by node, without visiting it
+			destinationParent->InsertEndChild (clone_element (source, destinationParent->GetDocument(), [] (const XMLElement *) { return true; }));
+			if (auto keyed = AttributeIndex::Of (destinationParent))
+				keyed->Insert (destinationParent->LastChildElement());
+			if (auto cache = SelectionCache::Of (destinationParent))
+				cache->Invalidate();
+		}
+
+
+		// copy only the elements for which keep (element) returns true, and their subtrees
+		template <typename F, typename = std::enable_if_t <std::is_invocable_r_v <bool, F, const XMLElement *>>>
+		inline void xcopy (const XMLElement * source, XMLElement * destinationParent, F keep)
+		{
+			if (auto copy = clone_element (source, destinationParent->GetDocument(), keep))
+			{
+				destinationParent->InsertEndChild (copy);
+				if (auto keyed = AttributeIndex::Of (destinationParent))
+					keyed->Insert (copy);
+				if (auto cache = SelectionCache::Of (destinationParent))
+					cache->Invalidate();
+			}
 		}
 
 
@@ -184,6 +260,194 @@ namespace tinyxml2
 		{
 			XMLCopyAndReplace copier (destinationParent, params, openDelim, closeDelim);
 			source->Accept (&copier);
+			if (auto keyed = AttributeIndex::Of (destinationParent))
+				keyed->Insert (destinationParent->LastChildElement());
+			if (auto cache = SelectionCache::Of (destinationParent))
+				cache->Invalidate();
+		}
+
+		inline void xcopy (const XMLElement * source, XMLElement * destinationParent, const std::unordered_map<std::string, std::string> & params, std::string_view openDelim, std::string_view closeDelim)
+		{
+			XMLCopyAndReplace copier (destinationParent, params, openDelim, closeDelim);
+			source->Accept (&copier);
+			if (auto keyed = AttributeIndex::Of (destinationParent))
+				keyed->Insert (destinationParent->LastChildElement());
+			if (auto cache = SelectionCache::Of (destinationParent))
+				cache->Invalidate();
+		}
+
+
+		class CompiledTemplate
+		{
+			// a template branch compiled once for copying any number of times, as xcopy with parameters copies it
+			// attribute values and text are split into literal and parameter segments when compiled, so that copying only joins them
+			// a compiled template is immutable and may be copied into any number of documents concurrently
+		public:
+			explicit CompiledTemplate (const XMLElement * source, char openDelim = '{', char closeDelim = '}')
+				: CompiledTemplate (source, std::string_view (&openDelim, 1), std::string_view (&closeDelim, 1)) {}
+			CompiledTemplate (const XMLElement * source, std::string_view openDelim, std::string_view closeDelim)
+			{
+				if (openDelim.empty() || closeDelim.empty())
+					throw XmlException ("empty parameter delimiter"s);
+				if (!source)
+					throw XmlException ("null element"s);
+				size_t depth = 0;
+				for (const XMLNode * node = source; node; )
+				{
+					bool copied = compile (node, depth);
+					if (copied && node->FirstChild())
+					{
+						++depth;
+						node = node->FirstChild();
+						continue;
+					}
+					for (; node != source && !node->NextSibling(); node = node->Parent())
+						--depth;
+					node = node != source ? node->NextSibling() : nullptr;
+				}
+				for (auto & value : _values)
+					split (value, openDelim, closeDelim);
+			}
+
+			// copy the template as the last child of destinationParent, returning the copy
+			XMLElement * Instantiate (XMLElement * destinationParent, const std::unordered_map<std::string, std::string> & params) const
+			{
+				auto doc = destinationParent->GetDocument();
+				std::vector<XMLNode *> parents {destinationParent};
+				std::string buffer;	// reused for each substituted value
+				for (auto const & node : _nodes)
+				{
+					parents.resize (node.depth + 1);
+					XMLNode * copy = nullptr;
+					switch (node.type)
+					{
+					case NodeType::element:
+					{
+						auto element = doc->NewElement (node.name.c_str());
+						for (auto attribute = node.attribute; attribute != node.attribute + node.nAttributes; ++attribute)
+							element->SetAttribute (_attributes [attribute].c_str(), value (node.value + attribute - node.attribute, params, buffer));
+						copy = element;
+						break;
+					}
+					case NodeType::text:
+						copy = doc->NewText (value (node.value, params, buffer));
+						break;
+					case NodeType::cdata:
+						copy = doc->NewText (node.name.c_str());
+						copy->ToText()->SetCData (true);
+						break;
+					case NodeType::comment:
+						copy = doc->NewComment (node.name.c_str());
+						break;
+					case NodeType::declaration:
+						copy = doc->NewDeclaration (node.name.c_str());
+						break;
+					}
+					parents.back()->InsertEndChild (copy);
+					parents.push_back (copy);
+				}
+				auto copy = destinationParent->LastChildElement();
+				if (auto keyed = AttributeIndex::Of (destinationParent))
+					keyed->Insert (copy);
+				if (auto cache = SelectionCache::Of (destinationParent))
+					cache->Invalidate();
+				return copy;
+			}
+
+		private:
+			enum class NodeType { element, text, cdata, comment, declaration };
+			struct Node
+			{
+				NodeType type;
+				size_t depth;
+				std::string name;	// element name, or the value of a node that isn't substituted
+				size_t attribute;	// first attribute name
+				size_t nAttributes;
+				size_t value;	// first value, of the attributes or text
+			};
+			struct Value
+			{
+				std::string text;	// as in the template
+				size_t segment {0};
+				size_t nSegments {0};	// none when there's nothing to substitute
+			};
+			struct Segment
+			{
+				std::string text;
+				bool parameter;
+			};
+
+			// record node, false if it isn't copied
+			bool compile (const XMLNode * node, size_t depth)
+			{
+				if (auto element = node->ToElement())
+				{
+					_nodes.push_back (Node {NodeType::element, depth, element->Name(), _attributes.size(), 0, _values.size()});
+					for (auto attribute = element->FirstAttribute(); attribute; attribute = attribute->Next())
+					{
+						_attributes.push_back (attribute->Name());
+						_values.push_back (Value {attribute->Value()});
+						++_nodes.back().nAttributes;
+					}
+				}
+				else if (auto text = node->ToText())
+				{
+					if (text->CData())	// we don't substitute CDATA
+						_nodes.push_back (Node {NodeType::cdata, depth, text->Value(), 0, 0, 0});
+					else
+					{
+						_nodes.push_back (Node {NodeType::text, depth, {}, 0, 0, _values.size()});
+						_values.push_back (Value {text->Value()});
+					}
+				}
+				else if (node->ToComment())
+					_nodes.push_back (Node {NodeType::comment, depth, node->Value(), 0, 0, 0});
+				else if (node->ToDeclaration())
+					_nodes.push_back (Node {NodeType::declaration, depth, node->Value(), 0, 0, 0});
+				else
+					return false;
+				return true;
+			}
+
+			// split value into literal and parameter segments, as XMLCopyAndReplace substitutes it
+			void split (Value & value, std::string_view openDelim, std::string_view closeDelim)
+			{
+				value.segment = _segments.size();
+				if (scan_parameters (value.text, openDelim, closeDelim,
+						[this] (std::string_view text) { _segments.push_back (Segment {std::string (text), false}); },
+						[this] (std::string_view name) { _segments.push_back (Segment {std::string (name), true}); }))
+					value.nSegments = _segments.size() - value.segment;
+			}
+
+			// value with parameters substituted
+			const char * value (size_t ix, const std::unordered_map<std::string, std::string> & params, std::string & buffer) const
+			{
+				auto const & value = _values [ix];
+				if (value.nSegments == 0)
+					return value.text.c_str();
+				buffer.clear();
+				for (auto segment = _segments.begin() + value.segment; segment != _segments.begin() + value.segment + value.nSegments; ++segment)
+				{
+					if (!segment->parameter)
+						buffer += segment->text;
+					else if (auto px = params.find (segment->text); px != params.end())
+						buffer += px->second;
+					else
+						throw XmlException ("no value for parameter " + segment->text);
+				}
+				return buffer.c_str();
+			}
+
+			std::vector<Node> _nodes;	// in document order
+			std::vector<std::string> _attributes;
+			std::vector<Value> _values;
+			std::vector<Segment> _segments;
+		};	// CompiledTemplate
+
+
+		inline XMLElement * xcopy (const CompiledTemplate & source, XMLElement * destinationParent, const std::unordered_map<std::string, std::string> & params)
+		{
+			return source.Instantiate (destinationParent, params);
 		}
 	}
 }
@@ -1,5 +1,5 @@
 /*
-tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14 features, such as iterators, strings and exceptions, to tinyxml2
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
 
 
 Copyright (c) 2017 Stan Thomas
@@ -26,10 +26,27 @@ It can be found here: https://github.com/leethomason/tinyxml2 and has it's own l
 #define __TINYXML_EX__
 
 #include <string>
+#include <string_view>
 #include <list>
+#include <optional>
+#include <charconv>
+#include <type_traits>
+#include <system_error>
 #include <memory>
+#include <vector>
+#include <forward_list>
+#include <algorithm>
+#include <chrono>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_set>
+#include <unordered_map>
 #include <exception>
+#include <stdexcept>
 #include <cassert>
+#include <cstring>
+#include <cstdio>
 
 #include "tinyxml2.h"
 
@@ -47,6 +64,23 @@ namespace tinyxml2
 		};
 
 
+		// XML that tinyxml2 failed to parse
+		class XmlParseError : public XmlException
+		{
+		public:
+			XmlParseError (const std::string & description, XMLError error, int line, size_t offset)
+				: XmlException (description), _error (error), _line (line), _offset (offset) {}
+			XMLError Error() const { return _error; }
+			int Line() const { return _line; }				// 0 if not known
+			size_t Offset() const { return _offset; }		// of the start of the line in error
+
+		private:
+			XMLError _error;
+			int _line;
+			size_t _offset;
+		};
+
+
 		class AttributeNameValue
 		{
 		public:
@@ -62,77 +96,183 @@ namespace tinyxml2
 		using attribute_list_t = std::list <AttributeNameValue>;
 
 
-		class ElementProperties
+		// XPath grammar, shared by paths parsed at run time and at compile time
+		// a path is a sequence of steps separated by '/', if it starts with '/' the first step is the document element
+		// each step is an element name, empty for any element, followed by optional attribute filters [@name='value'] or [@name]
+		// the parser reports each step to a builder as the sequence
+		//		Step() Char()* End() { Filter() Char()* End() Value() Char()* End() }
+		// where Step(), Filter() and Value() start the element name, an attribute name and its value respectively
+		template <typename Builder>
+		constexpr size_t parse_xpath_step (const char * xpath, size_t pos, size_t length, Builder & builder, bool descendant = false)
 		{
-		public:
-			ElementProperties (std::string xProps)
+			enum class ParseState { elementName, attributeFilter, attributeName, attributeAssignment, attributeValue, position, last } state {ParseState::elementName};
+			bool named = false;	// element name is complete, only attribute filters may follow
+			bool positioned = false;	// a step may have one positional filter
+			size_t position = 0;
+
+			builder .Step();
+			if (descendant)
+				builder .Descendant();
+			for (; pos < length && xpath [pos] != '/'; ++pos)
 			{
-				// parse xProps for element name and attribute filters using simplified XPath syntax
-				std::string attributeName, attributeValue;
-				for (auto c : xProps)
+				auto c = xpath [pos];
+				if (c == '[')
 				{
-					if (c == '[')
-					{
-						if (_state != ParseState::elementName)
-							throw XmlException ("ill formed XPath"s);
-						_state = ParseState::attributeFilter;
-					}
-					else if (c == ']')
+					if (state != ParseState::elementName)
+						throw XmlException ("ill formed XPath"s);
+					if (!named)
+						builder .End();
+					named = true;
+					state = ParseState::attributeFilter;
+				}
+				else if (c == ']')
+				{
+					if (state == ParseState::attributeName)
 					{
-						if (! (_state == ParseState::attributeFilter || _state == ParseState::attributeName || _state == ParseState::attributeAssignment  || _state == ParseState::attributeValue))
-							throw XmlException ("ill formed XPath"s);
-						if (_state == ParseState::attributeName || _state == ParseState::attributeAssignment || _state == ParseState::attributeValue)
-						{
-							_attributes .emplace_back (AttributeNameValue (attributeName, attributeValue));
-							attributeName .erase();
-							attributeValue .erase();
-						}
-						_state = ParseState::elementName;
+						// no value, filter on presence of attribute
+						builder .End();
+						builder .Value();
 					}
-					else if (c == '@')
+					if (state == ParseState::attributeName || state == ParseState::attributeAssignment || state == ParseState::attributeValue)
+						builder .End();
+					else if (state == ParseState::position || state == ParseState::last)
 					{
-						if (_state != ParseState::attributeFilter)
+						// positional filter, [n] counting from 1 or [last()]
+						if (positioned || (state == ParseState::position && position == 0))
 							throw XmlException ("ill formed XPath"s);
-						_state = ParseState::attributeName;
+						if (state == ParseState::position)
+							builder .Position (position);
+						else
+							builder .Last();
+						positioned = true;
 					}
-					else if (c == '=')
+					else if (state != ParseState::attributeFilter)
+						throw XmlException ("ill formed XPath"s);
+					state = ParseState::elementName;
+				}
+				else if (c == '@')
+				{
+					if (state != ParseState::attributeFilter)
+						throw XmlException ("ill formed XPath"s);
+					builder .Filter();
+					state = ParseState::attributeName;
+				}
+				else if (c == '=')
+				{
+					if (state != ParseState::attributeName)
+						throw XmlException ("ill formed XPath"s);
+					builder .End();
+					builder .Value();
+					state = ParseState::attributeAssignment;
+				}
+				else if (c == '\'')
+				{
+					if (!(state == ParseState::attributeAssignment || state == ParseState::attributeValue))
+						throw XmlException ("ill formed XPath"s);
+					// XPath attribute values are wrapped in single quote marks
+					// but we don't require them and ignore them if present
+					// toggle between two effectively equivalent modes
+					state = state == ParseState::attributeAssignment ? ParseState::attributeValue : ParseState::attributeAssignment;
+				}
+				else
+				{
+					switch (state)
 					{
-						if (_state != ParseState::attributeName)
+					case ParseState::elementName:
+						if (named)
 							throw XmlException ("ill formed XPath"s);
-						_state = ParseState::attributeAssignment;
-					}
-					else if (c == '\'')
-					{
-						if (!(_state == ParseState::attributeAssignment || _state == ParseState::attributeValue))
+						builder .Char (c);
+						break;
+					case ParseState::attributeName:
+					case ParseState::attributeAssignment:
+					case ParseState::attributeValue:
+						builder .Char (c);
+						break;
+					case ParseState::attributeFilter:
+						if (c >= '0' && c <= '9')
+						{
+							position = c - '0';
+							state = ParseState::position;
+						}
+						else if (length - pos >= 6 && xpath [pos] == 'l' && xpath [pos + 1] == 'a' && xpath [pos + 2] == 's' && xpath [pos + 3] == 't'
+								&& xpath [pos + 4] == '(' && xpath [pos + 5] == ')')
+						{
+							pos += 5;
+							state = ParseState::last;
+						}
+						break;	// skip anything else
+					case ParseState::position:
+						if (c < '0' || c > '9')
 							throw XmlException ("ill formed XPath"s);
-						// XPath attribute values are wrapped in single quote marks
-						// but we don't require them and ignore them if present
-						// toggle between two effectively equivalent modes
-						_state = _state == ParseState::attributeAssignment ? ParseState::attributeValue : ParseState::attributeAssignment;
+						position = position * 10 + (c - '0');
+						break;
+					case ParseState::last:
+						throw XmlException ("ill formed XPath"s);
 					}
-					else
+				}
+			}
+			// attribute filters must be closed within the step
+			if (state != ParseState::elementName)
+				throw XmlException ("ill formed XPath"s);
+			if (!named)
+				builder .End();
+			return pos;
+		}
+
+
+		template <typename Builder>
+		constexpr void parse_xpath (const char * xpath, size_t length, Builder & builder)
+		{
+			// a step following '//' matches descendants at any depth rather than only children
+			// a relative path may start with './', so that './/' selects descendants of the element it is applied to
+			size_t pos = length > 0 && xpath [0] == '/' ? 1 : length > 1 && xpath [0] == '.' && xpath [1] == '/' ? 2 : 0;
+			for (;;)
+			{
+				bool descendant = pos < length && xpath [pos] == '/';
+				if (descendant && ++pos < length && xpath [pos] == '/')
+					throw XmlException ("ill formed XPath"s);
+				if ((pos = parse_xpath_step (xpath, pos, length, builder, descendant)) >= length)
+					break;
+				++pos;	// step over '/'
+			}
+		}
+
+
+		class ElementProperties
+		{
+		public:
+			ElementProperties (std::string xProps)
+			{
+				// parse xProps for element name and attribute filters using simplified XPath syntax
+				struct Builder
+				{
+					ElementProperties & properties;
+					std::string * current {nullptr};
+					std::string attributeName {}, attributeValue {};
+
+					void Step() { current = &properties ._name; }
+					void Descendant() {}
+					void Position (size_t) { throw XmlException ("positional filter in element properties"s); }
+					void Last() { throw XmlException ("positional filter in element properties"s); }
+					void Filter() { current = &attributeName; }
+					void Value() { current = &attributeValue; }
+					void Char (char c) { *current += c; }
+					void End()
 					{
-						switch (_state)
+						if (current == &attributeValue)
 						{
-						case ParseState::elementName:
-							_name += c;
-							break;
-						case ParseState::attributeName:
-							attributeName += c;
-							break;
-						case ParseState::attributeAssignment:
-						case ParseState::attributeValue:
-							attributeValue += c;
-							break;
-						case ParseState::attributeFilter:
-							/*skip*/;
+							properties ._attributes .emplace_back (AttributeNameValue (attributeName, attributeValue));
+							attributeName .erase();
+							attributeValue .erase();
 						}
 					}
-				}
+				} builder {*this};
 
+				if (parse_xpath_step (xProps .c_str(), 0, xProps .size(), builder) != xProps .size())
+					throw XmlException ("ill formed XPath"s);
 			}
 			ElementProperties() {}	// an empty property set
-			std::string Name() const { return _name; }
+			const std::string & Name() const { return _name; }
 			bool Match (const XMLElement * element) const
 			{
 				// n.b. we only match attributes here, not the element name (type)
@@ -148,351 +288,2109 @@ namespace tinyxml2
 				for (auto const & attr : _attributes)
 					element -> SetAttribute (attr .Name() .c_str(), attr .Value() .c_str());
 			}
-		private:
-			std::string _name;
-			attribute_list_t _attributes;
-			enum class ParseState { elementName, attributeFilter, attributeName, attributeAssignment, attributeValue } _state {ParseState::elementName};
-		};	// ElementProperties
+		private:
+			std::string _name;
+			attribute_list_t _attributes;
+		};	// ElementProperties
+
+
+		// compiled XPath
+		// element names, attribute names and attribute values are held as null-terminated strings in a single character buffer
+		// steps and attribute filters refer to them by offset so that the compiled form can be built, and copied, at compile time
+		struct XPathStep
+		{
+			size_t name {0};
+			size_t filter {0};	// first attribute filter
+			size_t nFilters {0};
+			bool descendant {false};	// step follows '//'
+			size_t position {0};	// select only the nth of the matching siblings, counting from 1, 0 for all
+			bool last {false};	// select only the last of the matching siblings
+		};
+
+		struct XPathFilter
+		{
+			size_t name {0};
+			size_t value {0};	// empty value matches presence of attribute
+		};
+
+
+		template <typename Text, typename Steps, typename Filters>
+		class XPathBuilder
+		{
+			// builds compiled XPath from parser, storage may be std containers or, at compile time, FixedVector
+		public:
+			constexpr XPathBuilder (Text & text, Steps & steps, Filters & filters) : _text (text), _steps (steps), _filters (filters) {}
+
+			constexpr void Step() { _steps .push_back (XPathStep {_text .size(), _filters .size(), 0, false, 0, false}); }
+			constexpr void Descendant() { _steps .back() .descendant = true; }
+			constexpr void Position (size_t position) { _steps .back() .position = position; }
+			constexpr void Last() { _steps .back() .last = true; }
+			constexpr void Filter()
+			{
+				++_steps .back() .nFilters;
+				_filters .push_back (XPathFilter {_text .size(), 0});
+			}
+			constexpr void Value() { _filters .back() .value = _text .size(); }
+			constexpr void Char (char c) { _text .push_back (c); }
+			constexpr void End() { _text .push_back ('\0'); }
+
+		private:
+			Text & _text;
+			Steps & _steps;
+			Filters & _filters;
+		};	// XPathBuilder
+
+
+		class XPath
+		{
+			// an XPath parsed once so that it can be reused for any number of selections
+			// a compiled XPath is immutable; copies share the parsed steps and may be used concurrently from any thread and on any document
+		public:
+			XPath() {}	// an empty path, selects nothing
+			explicit XPath (std::string_view xpath) : _absolute (!xpath .empty() && xpath [0] == '/')
+			{
+				if (xpath .empty())
+					return;
+
+				auto compiled = std::make_shared<Compiled>();
+				XPathBuilder<std::string, std::vector<XPathStep>, std::vector<XPathFilter>> builder (compiled -> text, compiled -> steps, compiled -> filters);
+				parse_xpath (xpath .data(), xpath .size(), builder);
+
+				_text = compiled -> text .data();
+				_steps = compiled -> steps .data();
+				_nSteps = compiled -> steps .size();
+				_filters = compiled -> filters .data();
+				_compiled = std::move (compiled);
+			}
+			// refer to compiled path data held elsewhere, which must outlive the XPath and all copies of it
+			XPath (const char * text, const XPathStep * steps, size_t nSteps, const XPathFilter * filters, bool absolute)
+				: _text (text), _steps (steps), _nSteps (nSteps), _filters (filters), _absolute (absolute) {}
+
+			bool Absolute() const { return _absolute; }
+			bool Empty() const { return _nSteps == 0; }
+			size_t Size() const { return _nSteps; }
+
+			// element name at step, empty for any element
+			const char * Name (size_t ix) const { return _text + _steps [ix] .name; }
+			// step matches descendants at any depth below the previous step rather than only its children
+			bool Descendant (size_t ix) const { return _steps [ix] .descendant; }
+			// positional filter at step, nth of the siblings matching name and attribute filters counting from 1, 0 for none
+			size_t Position (size_t ix) const { return _steps [ix] .position; }
+			bool Last (size_t ix) const { return _steps [ix] .last; }
+
+			bool Match (size_t ix, const XMLElement * element) const
+			{
+				// n.b. we only match attributes here, not the element name (type)
+				auto const & step = _steps [ix];
+				for (auto filter = _filters + step .filter; filter != _filters + step .filter + step .nFilters; ++filter)
+				{
+					auto value = _text + filter -> value;
+					if (!element -> Attribute (_text + filter -> name, *value ? value : nullptr))
+						return false;	// attribute not matched
+				}
+				return true;
+			}
+
+			// attribute filters at step, an empty value matches presence of the attribute
+			size_t Filters (size_t ix) const { return _steps [ix] .nFilters; }
+			const char * FilterName (size_t ix, size_t ixFilter) const { return _text + _filters [_steps [ix] .filter + ixFilter] .name; }
+			const char * FilterValue (size_t ix, size_t ixFilter) const { return _text + _filters [_steps [ix] .filter + ixFilter] .value; }
+
+			void Update (size_t ix, XMLElement * element) const
+			{
+				auto const & step = _steps [ix];
+				for (auto filter = _filters + step .filter; filter != _filters + step .filter + step .nFilters; ++filter)
+					element -> SetAttribute (_text + filter -> name, _text + filter -> value);
+			}
+
+			// the first n steps, or the steps from ix on as a path relative to an element matching step ix - 1
+			XPath Prefix (size_t n) const
+			{
+				XPath xpath (*this);
+				xpath ._nSteps = n;
+				return xpath;
+			}
+			XPath Suffix (size_t ix) const
+			{
+				XPath xpath (*this);
+				xpath ._steps += ix;
+				xpath ._nSteps -= ix;
+				xpath ._absolute = false;
+				return xpath;
+			}
+
+			// the same path taken from the document rather than the element it is applied to
+			XPath FromDocument() const
+			{
+				XPath xpath (*this);
+				xpath ._absolute = true;
+				return xpath;
+			}
+
+		private:
+			struct Compiled
+			{
+				std::string text;
+				std::vector<XPathStep> steps;
+				std::vector<XPathFilter> filters;
+			};
+
+			const char * _text {nullptr};
+			const XPathStep * _steps {nullptr};
+			size_t _nSteps {0};
+			const XPathFilter * _filters {nullptr};
+			bool _absolute {false};
+			std::shared_ptr<const Compiled> _compiled;
+
+			friend class SelectionCache;
+		};	// XPath
+
+
+		// the text of a compiled path, as it would be written
+		inline std::string xpath_string (const XPath & xpath)
+		{
+			std::string text;
+			for (size_t ixStep = 0; ixStep < xpath .Size(); ++ixStep)
+			{
+				if (ixStep > 0 || xpath .Absolute())
+					text += '/';
+				else if (xpath .Descendant (ixStep))
+					text += "./";
+				if (xpath .Descendant (ixStep))
+					text += '/';
+				text += xpath .Name (ixStep);
+				for (size_t ixFilter = 0; ixFilter < xpath .Filters (ixStep); ++ixFilter)
+				{
+					text += "[@"s + xpath .FilterName (ixStep, ixFilter);
+					if (*xpath .FilterValue (ixStep, ixFilter))
+						text += "='"s + xpath .FilterValue (ixStep, ixFilter) + "'"s;
+					text += ']';
+				}
+				if (xpath .Position (ixStep))
+					text += "["s + std::to_string (xpath .Position (ixStep)) + "]"s;
+				else if (xpath .Last (ixStep))
+					text += "[last()]"s;
+			}
+			return text;
+		}
+
+
+		template <typename T, size_t N>
+		class FixedVector
+		{
+			// minimal fixed capacity vector for building compiled XPath at compile time
+		public:
+			constexpr void push_back (const T & item)
+			{
+				if (_size == N)
+					throw XmlException ("XPath exceeds capacity"s);
+				_items [_size++] = item;
+			}
+			constexpr T & back() { return _items [_size - 1]; }
+			constexpr size_t size() const { return _size; }
+			constexpr const T * data() const { return _items; }
+
+		private:
+			T _items [N] {};
+			size_t _size {0};
+		};	// FixedVector
+
+
+		template <size_t N>
+		class XPathLiteral
+		{
+			// an XPath parsed at compile time, an ill formed path fails to compile
+			// the compiled path is held in fixed size arrays and never allocates
+			// declare with static storage duration, e.g. static constexpr XPathLiteral cOfB {"A/B/C"};
+			// and pass to selection() or find_element() where it is used in place as a compiled XPath
+		public:
+			constexpr XPathLiteral (const char (&xpath) [N]) : _absolute (N > 1 && xpath [0] == '/')
+			{
+				if (N > 1)
+				{
+					XPathBuilder<decltype(_text), decltype(_steps), decltype(_filters)> builder (_text, _steps, _filters);
+					parse_xpath (xpath, N - 1, builder);
+				}
+			}
+
+			operator XPath() const & { return XPath (_text .data(), _steps .data(), _steps .size(), _filters .data(), _absolute); }
+			operator XPath() const && = delete;	// a temporary would leave the XPath dangling
+
+		private:
+			// every path character is copied at most once and each name and value terminator replaces a separator,
+			// so the compiled text is no longer than the path, each step takes at least a '/' and each filter at least "[@]"
+			FixedVector<char, N> _text;
+			FixedVector<XPathStep, N> _steps;
+			FixedVector<XPathFilter, N / 3 + 1> _filters;
+			bool _absolute;
+		};	// XPathLiteral
+
+
+#if __cpp_nontype_template_args >= 201911L
+		// user-defined literal parsing an XPath at compile time, e.g. selection (*doc, "A/B[@id='three']/C"_xpath)
+		template <size_t N>
+		struct XPathString
+		{
+			constexpr XPathString (const char (&xpath) [N])
+			{
+				for (size_t ix = 0; ix < N; ++ix)
+					value [ix] = xpath [ix];
+			}
+			char value [N] {};
+		};
+
+		template <XPathString S> inline constexpr XPathLiteral<sizeof (S .value)> xpath_literal {S .value};
+
+		inline namespace literals
+		{
+			template <XPathString S> constexpr const auto & operator ""_xpath() { return xpath_literal<S>; }
+		}
+#endif
+
+
+		// path matching any element, used for iteration over all child elements
+		inline const XPath & any_element()
+		{
+			static const XPathStep step {};
+			static const XPath any ("", &step, 1, nullptr, false);
+			return any;
+		}
+
+
+		// locate the origin of a compiled XPath applied to root, the element whose children are matched by the first step
+		//	if path starts with '/' then it is relative to document, otherwise relative to element passed in
+		// sets firstStep to the step matching children of the origin
+		template <typename XE> inline XE * xpath_origin (XE * root, const XPath & xpath, size_t & firstStep)
+		{
+			if (!root)
+				throw XmlException ("null element"s);
+
+			firstStep = 0;
+			if (!xpath .Absolute())
+				return root;
+
+			// document is not an element so needs special handling
+			// advance to the actual document element
+			// note that document element must still appear in path, so we have to step over it
+			// for document-based paths, this works because there can only be one document element
+			firstStep = xpath .Size();
+			if (xpath .Size() < 2)
+				return nullptr;	// a path naming only the document element selects nothing
+
+			auto element = root -> GetDocument() -> RootElement();
+			auto name = xpath .Name (0);
+			if (element && *name)
+			{
+				if (strcmp (name, element -> Name()) != 0)
+					throw XmlException ("document element name mismatch"s);
+			}
+			firstStep = 1;
+			return element;
+		}
+
+
+		// pre-order successor of element within the subtree of top, nullptr when the subtree is exhausted
+		template <typename XE> inline XE * next_element (XE * element, const XMLNode * top)
+		{
+			if (auto child = element -> FirstChildElement())
+				return child;
+			for (decltype (element -> Parent()) node = element; node && node != top; node = node -> Parent())
+			{
+				if (auto sibling = node -> NextSiblingElement())
+					return sibling;
+			}
+			return nullptr;
+		}
+
+
+		// true when a precedes b in document order
+		inline bool precedes (const XMLNode * a, const XMLNode * b)
+		{
+			auto depth = [] (const XMLNode * node)
+			{
+				size_t depth = 0;
+				while ((node = node -> Parent()))
+					++depth;
+				return depth;
+			};
+			if (a == b)
+				return false;
+
+			// an ancestor precedes its descendants, otherwise compare the children of the common ancestor
+			auto depthA = depth (a);
+			auto depthB = depth (b);
+			for (; depthA > depthB; --depthA)
+				if ((a = a -> Parent()) == b)
+					return false;
+			for (; depthB > depthA; --depthB)
+				if ((b = b -> Parent()) == a)
+					return true;
+			while (a -> Parent() != b -> Parent())
+			{
+				a = a -> Parent();
+				b = b -> Parent();
+			}
+			// search both ways from a, so the cost is the distance between the siblings
+			for (auto next = a -> NextSibling(), previous = a -> PreviousSibling(); next || previous; )
+			{
+				if (next == b)
+					return true;
+				if (previous == b)
+					return false;
+				if (next)
+					next = next -> NextSibling();
+				if (previous)
+					previous = previous -> PreviousSibling();
+			}
+			return false;
+		}
+
+
+		class NameTable
+		{
+			// opt-in table of the element names of a document, each distinct name is held once
+			// selections given the table match element names by pointer comparison rather than string comparison
+			// the user data of each element is set to its interned name, elements whose user data is already in use are refused,
+			// and the table clears the user data it set when it is destroyed, so the document must outlive the table
+			// elements added after the table is built are matched by name, rebuild the table after renaming elements
+			// the table must outlive selections using it
+		public:
+			explicit NameTable (XMLDocument & doc) : _doc (doc) { Rebuild(); }
+			~NameTable()
+			{
+				// leave no element pointing at the names freed with the table
+				for (auto element = _doc .RootElement(); element; element = next_element (element, &_doc))
+				{
+					if (interned (element -> GetUserData()))
+						element -> SetUserData (nullptr);
+				}
+			}
+			NameTable (const NameTable &) = delete;
+			NameTable & operator = (const NameTable &) = delete;
+
+			void Rebuild()
+			{
+				// check every element before changing any
+				for (auto element = _doc .RootElement(); element; element = next_element (element, &_doc))
+					check (element);
+				for (auto element = _doc .RootElement(); element; element = next_element (element, &_doc))
+					set (element);
+			}
+
+			void Intern (XMLElement * element)
+			{
+				check (element);
+				set (element);
+			}
+
+			const XMLDocument & Document() const { return _doc; }
+
+			// interned name, which when no element has the name, matches no element
+			const void * Find (const char * name) const
+			{
+				auto ix = _names .find (name);
+				return ix != _names .end() ? ix -> data() : &_absent;
+			}
+
+		private:
+			bool interned (const void * data) const { return data && _interned .count (data); }
+
+			void check (const XMLElement * element) const
+			{
+				if (element -> GetUserData() && !interned (element -> GetUserData()))
+					throw XmlException ("element user data already in use"s);
+			}
+
+			void set (XMLElement * element)
+			{
+				auto ix = _names .find (element -> Name());
+				if (ix == _names .end())
+				{
+					_store .emplace_front (element -> Name());
+					ix = _names .emplace (_store .front()) .first;
+					_interned .insert (ix -> data());
+				}
+				element -> SetUserData (const_cast<char *> (ix -> data()));
+			}
+
+			XMLDocument & _doc;
+			std::forward_list<std::string> _store;	// interned names, never moved once added
+			std::unordered_set<std::string_view> _names;
+			std::unordered_set<const void *> _interned;	// the user data set by the table
+			const char _absent {};
+		};	// NameTable
+
+
+		class DocumentIndex
+		{
+			// opt-in index of the elements of a document by element name, each list in document order
+			// selections given the index visit only the elements named by the last step of the path, checking their ancestors against the preceding steps
+			// the index is a snapshot of the document, Rebuild() after adding, removing or renaming elements
+			// the index must outlive selections using it
+		public:
+			explicit DocumentIndex (XMLDocument & doc) : _doc (doc) { Rebuild(); }
+			DocumentIndex (const DocumentIndex &) = delete;
+			DocumentIndex & operator = (const DocumentIndex &) = delete;
+
+			void Rebuild()
+			{
+				// one pre-order pass over the document
+				_byName .clear();
+				_store .clear();
+				_all .clear();
+				for (auto element = _doc .RootElement(); element; element = next_element (element, &_doc))
+				{
+					_all .push_back (element);
+					elements (element -> Name()) .push_back (element);
+				}
+			}
+
+			const XMLDocument & Document() const { return _doc; }
+
+			// all elements, or the elements with name
+			const std::vector<XMLElement *> & Elements() const { return _all; }
+			const std::vector<XMLElement *> & Elements (const char * name) const
+			{
+				auto ix = _byName .find (name);
+				return ix != _byName .end() ? ix -> second : _none;
+			}
+
+		private:
+			std::vector<XMLElement *> & elements (const char * name)
+			{
+				auto ix = _byName .find (name);
+				if (ix == _byName .end())
+				{
+					_store .emplace_front (name);
+					ix = _byName .emplace (_store .front(), std::vector<XMLElement *>()) .first;
+				}
+				return ix -> second;
+			}
+
+			XMLDocument & _doc;
+			std::forward_list<std::string> _store;	// element names keying the index
+			std::unordered_map<std::string_view, std::vector<XMLElement *>> _byName;
+			std::vector<XMLElement *> _all;
+			const std::vector<XMLElement *> _none;
+		};	// DocumentIndex
+
+
+		class AttributeIndex
+		{
+			// opt-in hash index of the elements of a document keyed on element name, attribute name and attribute value
+			// selections and find_element given the index, when the last step of the path filters on the value of an indexed attribute,
+			// visit only the elements with that value
+			// append_element, prepend_element, insert_next_element, ElementAppender and xcopy keep the index up to date;
+			// call Rebuild() after other edits, including setting or deleting attributes and moving or deleting elements with tinyxml2,
+			// until then the index may hold elements that are no longer in the document
+			// the index must outlive selections using it
+		public:
+			explicit AttributeIndex (XMLDocument & doc) : _doc (doc)
+			{
+				auto & registry = documents();
+				std::unique_lock<std::shared_mutex> lock (registry .mutex);
+				if (!registry .indexes .emplace (&doc, this) .second)
+					throw XmlException ("document already has an attribute index"s);
+				++registry .count;
+			}
+			~AttributeIndex()
+			{
+				auto & registry = documents();
+				std::unique_lock<std::shared_mutex> lock (registry .mutex);
+				registry .indexes .erase (&_doc);
+				--registry .count;
+			}
+			AttributeIndex (const AttributeIndex &) = delete;
+			AttributeIndex & operator = (const AttributeIndex &) = delete;
+
+			// index elements with elementName on the value of attributeName
+			void Declare (const std::string & elementName, const std::string & attributeName)
+			{
+				for (auto const & key : _keys)
+				{
+					if (key .element == elementName && key .attribute == attributeName)
+						return;
+				}
+				_keys .push_back (Key {elementName, attributeName, {}, {}});
+				for (auto element = _doc .RootElement(); element; element = next_element (element, &_doc))
+				{
+					if (auto elements = this -> elements (_keys .back(), element))
+						elements -> push_back (element);
+				}
+			}
+
+			void Rebuild()
+			{
+				for (auto & key : _keys)
+				{
+					key .values .clear();
+					key .store .clear();
+				}
+				for (auto element = _doc .RootElement(); element; element = next_element (element, &_doc))
+				{
+					for (auto & key : _keys)
+					{
+						if (auto elements = this -> elements (key, element))
+							elements -> push_back (element);
+					}
+				}
+			}
+
+			// index a newly inserted element and its descendants
+			void Insert (XMLElement * inserted)
+			{
+				for (auto element = inserted; element; element = next_element (element, inserted))
+				{
+					for (auto & key : _keys)
+					{
+						auto elements = this -> elements (key, element);
+						if (!elements)
+							continue;
+						// keep document order, new elements are most often added at the end
+						if (elements -> empty() || precedes (elements -> back(), element))
+							elements -> push_back (element);
+						else
+						{
+							auto position = std::upper_bound (elements -> begin(), elements -> end(), element,
+								[] (const XMLElement * a, const XMLElement * b) { return precedes (a, b); });
+							if (position == elements -> begin() || *(position - 1) != element)
+								elements -> insert (position, element);
+						}
+					}
+				}
+			}
+
+			// elements with value of attribute, in document order, or nullptr when the attribute is not indexed for elementName
+			const std::vector<XMLElement *> * Find (const char * elementName, const char * attributeName, const char * value) const
+			{
+				for (auto const & key : _keys)
+				{
+					if (key .element == elementName && key .attribute == attributeName)
+					{
+						auto ix = key .values .find (value);
+						return ix != key .values .end() ? &ix -> second : &_none;
+					}
+				}
+				return nullptr;
+			}
+
+			// candidates for a step of an XPath filtering on the value of an indexed attribute, or nullptr
+			const std::vector<XMLElement *> * Find (const XPath & xpath, size_t ixStep) const
+			{
+				auto name = xpath .Name (ixStep);
+				if (!*name)
+					return nullptr;
+				for (size_t ixFilter = 0; ixFilter < xpath .Filters (ixStep); ++ixFilter)
+				{
+					auto value = xpath .FilterValue (ixStep, ixFilter);
+					if (!*value)
+						continue;	// presence of attribute
+					if (auto elements = Find (name, xpath .FilterName (ixStep, ixFilter), value))
+						return elements;
+				}
+				return nullptr;
+			}
+
+			const XMLDocument & Document() const { return _doc; }
+
+			// the index declared on the document of node, if any, for the editing functions to keep up to date
+			static AttributeIndex * Of (const XMLNode * node)
+			{
+				auto & registry = documents();
+				if (registry .count == 0)
+					return nullptr;
+				std::shared_lock<std::shared_mutex> lock (registry .mutex);
+				auto ix = registry .indexes .find (node -> GetDocument());
+				return ix != registry .indexes .end() ? ix -> second : nullptr;
+			}
+
+		private:
+			struct Key
+			{
+				std::string element;
+				std::string attribute;
+				std::forward_list<std::string> store;	// attribute values keying the index
+				std::unordered_map<std::string_view, std::vector<XMLElement *>> values;
+			};
+
+			struct Registry
+			{
+				std::shared_mutex mutex;
+				std::unordered_map<const XMLDocument *, AttributeIndex *> indexes;
+				std::atomic<size_t> count {0};	// so that documents without an index need not take the lock
+			};
+
+			static Registry & documents()
+			{
+				static Registry registry;
+				return registry;
+			}
+
+			std::vector<XMLElement *> * elements (Key & key, const XMLElement * element)
+			{
+				// index entry for element, or nullptr if element does not have the key
+				if (key .element != element -> Name())
+					return nullptr;
+				auto value = element -> Attribute (key .attribute .c_str());
+				if (!value)
+					return nullptr;
+				auto ix = key .values .find (value);
+				if (ix == key .values .end())
+				{
+					key .store .emplace_front (value);
+					ix = key .values .emplace (key .store .front(), std::vector<XMLElement *>()) .first;
+				}
+				return &ix -> second;
+			}
+
+			XMLDocument & _doc;
+			std::list<Key> _keys;
+			const std::vector<XMLElement *> _none;
+		};	// AttributeIndex
+
+
+#if defined (TIXML2EX_QUERY_STATS)
+		inline constexpr bool query_stats_enabled = true;
+#else
+		inline constexpr bool query_stats_enabled = false;
+#endif
+
+		struct QueryStats
+		{
+			// what selections did, counted only when compiled with TIXML2EX_QUERY_STATS defined, otherwise all stay 0
+			// elements visited are all those the selection moved to, including those rejected on name (skipped)
+			// predicates are the attribute and position filters checked, matched the elements selected
+			std::atomic<uint64_t> queries {0};
+			std::atomic<uint64_t> visited {0};
+			std::atomic<uint64_t> skipped {0};
+			std::atomic<uint64_t> predicates {0};
+			std::atomic<uint64_t> failed {0};
+			std::atomic<uint64_t> matched {0};
+			std::atomic<uint64_t> nanoseconds {0};	// spent selecting, not including the caller's work between elements
+
+			void Reset()
+			{
+				for (auto counter : {&queries, &visited, &skipped, &predicates, &failed, &matched, &nanoseconds})
+					counter -> store (0, std::memory_order_relaxed);
+			}
+		};	// QueryStats
+
+
+		class QueryRegistry
+		{
+			// statistics of selections traced to the registry, aggregated by path
+			// the global registry, once enabled, traces every selection made with a path
+		public:
+			QueryRegistry() {}
+			QueryRegistry (const QueryRegistry &) = delete;
+			QueryRegistry & operator = (const QueryRegistry &) = delete;
+
+			static QueryRegistry & Global()
+			{
+				static QueryRegistry registry;
+				return registry;
+			}
+			void Enable (bool enable = true) { _enabled .store (enable, std::memory_order_relaxed); }
+			bool Enabled() const { return _enabled .load (std::memory_order_relaxed); }
+
+			// statistics for xpath, which stay in place for the life of the registry
+			QueryStats & Stats (const XPath & xpath)
+			{
+				auto text = xpath_string (xpath);
+				std::lock_guard<std::mutex> lock (_mutex);
+				return _paths .try_emplace (std::move (text)) .first -> second;
+			}
+
+			void Reset()
+			{
+				std::lock_guard<std::mutex> lock (_mutex);
+				for (auto & path : _paths)
+					path .second .Reset();
+			}
+
+			// a line for each path, those taking the longest first
+			std::string Dump() const
+			{
+				struct Line { const std::string * path; uint64_t counts [7]; };
+				std::vector<Line> lines;
+				{
+					std::lock_guard<std::mutex> lock (_mutex);
+					for (auto const & [path, stats] : _paths)
+						lines .push_back (Line {&path, {stats .queries, stats .visited, stats .skipped, stats .predicates, stats .failed, stats .matched, stats .nanoseconds}});
+				}
+				std::sort (lines .begin(), lines .end(), [] (const Line & a, const Line & b) { return a .counts [6] > b .counts [6]; });
+				std::string dump;
+				for (auto const & line : lines)
+				{
+					char text [256];
+					snprintf (text, sizeof text, " : %llu queries, %llu visited, %llu skipped by name, %llu predicates, %llu failed, %llu matched, %.3f ms\n",
+						(unsigned long long) line .counts [0], (unsigned long long) line .counts [1], (unsigned long long) line .counts [2], (unsigned long long) line .counts [3],
+						(unsigned long long) line .counts [4], (unsigned long long) line .counts [5], line .counts [6] / 1e6);
+					dump += *line .path + text;
+				}
+				return dump;
+			}
+
+		private:
+			mutable std::mutex _mutex;
+			std::unordered_map<std::string, QueryStats> _paths;
+			std::atomic<bool> _enabled {false};
+		};	// QueryRegistry
+
+
+		// where an iterator counts what it does, for the one query and for its path
+		struct QueryTrace
+		{
+			QueryStats * query {nullptr};
+			QueryStats * path {nullptr};
+		};
+
+
+		template <typename XE> class Selector;
+
+
+		template <typename XE>
+		class ElementIterator
+		{
+		public:
+			// iterator_traits
+			using iterator_category = std::input_iterator_tag;
+			using value_type = XE;
+			using difference_type = std::ptrdiff_t;
+			using pointer = XE *;
+			using reference = XE &;
+
+
+		public:
+			ElementIterator() {}	// an empty iterator that will return a null XMLElement
+			ElementIterator (XE * first) : _xpath (any_element()), _depth (1)
+			{
+				// iterate over first and its sibling elements
+				_local [0] .element = _current = first;
+				_scanLevel = 1;
+			}
+			ElementIterator (XE * origin, std::string_view xpath) : ElementIterator (origin, XPath (xpath)) {}
+			ElementIterator (XE * origin, const XPath & xpath, const NameTable * names = nullptr, const DocumentIndex * index = nullptr,
+					const AttributeIndex * keys = nullptr, QueryTrace trace = {})
+				: _xpath (xpath), _names (names)
+			{
+#if defined (TIXML2EX_QUERY_STATS)
+				_trace = trace;
+#else
+				(void) trace;
+#endif
+				Timed timed (*this);
+				count (&QueryStats::queries);
+
+				// the selection branch holds the element matched at each step of the path below the origin
+				// only children of the origin are considered
+				// elements in the branch are initially null
+				if (origin && _xpath .Absolute() && !_xpath .Empty() && _xpath .Descendant (0))
+				{
+					// a path starting '//' selects from the whole document, the document element included
+					_top = origin -> GetDocument();
+					origin = origin -> GetDocument() -> RootElement();
+				}
+				else
+					_top = origin = xpath_origin (origin, _xpath, _firstStep);
+				_depth = _xpath .Size() - _firstStep;
+				if (_depth > localDepth)
+					_deep .resize (_depth);
+
+				// resolve the element name to match at each step once
+				auto cursor = branch();
+				for (size_t level = 0; level < _depth; ++level)
+				{
+					auto name = _xpath .Name (_firstStep + level);
+					cursor [level] .name = !*name ? nullptr : _names ? _names -> Find (name) : name;
+				}
+				// steps from the first descendant step on are matched by scanning the subtree below the branch
+				_scanLevel = _depth;
+				for (size_t level = 0; level < _depth; ++level)
+				{
+					if (_xpath .Descendant (_firstStep + level))
+					{
+						_scanLevel = level;
+						break;
+					}
+				}
+
+				if (!_depth || !origin)
+					return;
+				// candidates are the indexed elements for the last step, in document order
+				auto ixLast = _xpath .Size() - 1;
+				if (index)
+				{
+					auto name = _xpath .Name (ixLast);
+					_candidates = *name ? &index -> Elements (name) : &index -> Elements();
+				}
+				else if (keys)
+					_candidates = keys -> Find (_xpath, ixLast);
+
+				if (_candidates)
+				{
+					_scanLevel = 0;
+					advance();
+				}
+				else if (_scanLevel == 0)
+					scan (_top, _top == origin ? origin -> FirstChildElement() : origin);
+				else
+				{
+					// descend and initialise first matching branch (if any)
+					walk (0, first (origin, cursor [0] .name, _firstStep));
+				}
+				count (&QueryStats::matched, _current != nullptr);
+			}
+			XE * operator *() const { return _current; }
+			bool operator == (const ElementIterator & iter) const { return *iter == **this; }
+			bool operator != (const ElementIterator & iter) const { return ! operator == (iter); }
+			ElementIterator & operator ++()
+			{
+				Timed timed (*this);
+				step();
+				count (&QueryStats::matched, _current != nullptr);
+				return *this;
+			}
+
+		private:
+			void step()
+			{
+				if (_remaining && --_remaining == 0)
+				{
+					_current = nullptr;	// selection window complete, stop traversal
+					return;
+				}
+				if (_candidates)
+				{
+					++_ixCandidate;
+					advance();
+					return;
+				}
+				if (_scanLevel < _depth)
+				{
+					// continue the descendant scan, then move the branch above it along
+					if (!scan (_top, next_element (_current, _top)) && _scanLevel > 0)
+					{
+						auto level = _scanLevel - 1;
+						auto const & cursor = branch() [level];
+						walk (level, next (cursor .element, cursor .name, _firstStep + level));
+					}
+					return;
+				}
+
+				// to get here we must have found at least one matching element
+				// selection branch contains the complete element path
+#if !defined (NDEBUG)
+				for (size_t level = 0; level < _scanLevel; ++level)
+					assert (branch() [level] .element);
+#endif
+				// start at the bottom with the siblings of the current element, then walk the rest of the branch
+				auto level = _depth - 1;
+				auto ixStep = _firstStep + level;
+				auto & cursor = branch() [level];
+				auto element = _current;
+				while ((element = next (element, cursor .name, ixStep)))
+				{
+					if (match (ixStep, element))
+					{
+						cursor .element = _current = element;
+						return;
+					}
+				}
+				walk (level, element);
+			}
+
+			void walk (size_t level, XE * element)
+			{
+				// find the next matching branch, the branch is an explicit stack holding the candidate element at each level
+				// starting from element, the next candidate at level, we can go sideways, down to the first child of a matching element
+				// or, when a level is exhausted, up and sideways
+				auto cursor = branch();
+				auto ixStep = _firstStep + level;
+				for (;;)
+				{
+					while (element && !match (ixStep, element))
+						element = next (element, cursor [level] .name, ixStep);	// move sideways
+					cursor [level] .element = element;
+
+					if (element)
+					{
+						if (level + 1 == _scanLevel)
+						{
+							if (_scanLevel == _depth)
+								break;	// we've found the next matching element
+							if (scan (element, element -> FirstChildElement()))
+								return;	// found below the branch
+							element = next (element, cursor [level] .name, ixStep);	// nothing below, move sideways
+							continue;
+						}
+						// move down
+						++level;
+						element = first (element, cursor [level] .name, ++ixStep);
+					}
+					else
+					{
+						// no siblings or sibling branches match, go up a level (unless already at top)
+						if (level == 0)
+							break;	// selection is exhausted
+						--level;
+						element = next (cursor [level] .element, cursor [level] .name, --ixStep);
+					}
+				}
+				_current = element;
+			}
+
+			void advance()
+			{
+				// the next candidate whose ancestors match the path up to the origin
+				for (; _ixCandidate < _candidates -> size(); ++_ixCandidate)
+				{
+					XE * element = (*_candidates) [_ixCandidate];
+					if (tracing())
+						visit (element);
+					if (ascend (element, _depth - 1, _top, false))
+					{
+						_current = element;
+						return;
+					}
+				}
+				_current = nullptr;
+			}
+
+			bool scan (const XMLNode * top, XE * element)
+			{
+				// the next element, in document order below top, matching the steps from the scan level
+				for (; element; element = next_element (element, top))
+				{
+					if (tracing())
+						visit (element);
+					if (ascend (element, _depth - 1, top, true))
+					{
+						_top = top;
+						_current = element;
+						return true;
+					}
+				}
+				_current = nullptr;
+				return false;
+			}
+
+			bool ascend (const XMLElement * element, size_t level, const XMLNode * top, bool scanned) const
+			{
+				// element matches the step at level and its ancestors below top match the steps above, down to the scan level
+				// scanned elements are known to descend from top
+				auto cursor = branch();
+				for (;;)
+				{
+					auto ixStep = _firstStep + level;
+					if (!named (element, cursor [level] .name, ixStep) || !match (ixStep, element)
+							|| !positioned (element, cursor [level] .name, ixStep))
+						return false;
+					const XMLNode * parent = element -> Parent();
+					if (_xpath .Descendant (ixStep))
+					{
+						if (level == _scanLevel && scanned)
+							return true;
+						// any ancestor below top may match the step above
+						for (; parent && parent != top; parent = parent -> Parent())
+						{
+							auto ancestor = parent -> ToElement();
+							if (level > _scanLevel && ancestor && ascend (ancestor, level - 1, top, scanned))
+								return true;
+						}
+						return level == _scanLevel && parent == top;
+					}
+					if (level == _scanLevel)
+						return parent == top;
+					if (!parent || parent == top || !(element = parent -> ToElement()))
+						return false;
+					--level;
+				}
+			}
+
+			bool named (const XMLElement * element, const void * name, size_t ixStep) const
+			{
+				// elements added since a name table was built have no user data and are compared by name
+				if (!name)
+					return true;
+				if (!_names)
+					return strcmp (element -> Name(), static_cast<const char *> (name)) == 0;
+				return element -> GetUserData() == name
+						|| (!element -> GetUserData() && strcmp (element -> Name(), _xpath .Name (ixStep)) == 0);
+			}
+
+			bool match (size_t ixStep, const XMLElement * element) const
+			{
+				// the attribute filters of step
+				auto matched = _xpath .Match (ixStep, element);
+				if (tracing() && _xpath .Filters (ixStep))
+				{
+					count (&QueryStats::predicates);
+					count (&QueryStats::failed, !matched);
+				}
+				return matched;
+			}
+
+			// first child and next sibling with element name of step, or any element when name is null
+			// a positional step has only the one child, found by counting forwards or, for last(), searching backwards
+			XE * first (XE * parent, const void * name, size_t ixStep) const
+			{
+				if (_xpath .Last (ixStep))
+				{
+					auto element = _names ? lastChild (parent, nullptr) : lastChild (parent, static_cast<const char *> (name));
+					for (; element; element = _names ? previousSibling (element, nullptr) : previousSibling (element, static_cast<const char *> (name)))
+					{
+						if (!named (element, name, ixStep))
+							count (&QueryStats::skipped);
+						else if (match (ixStep, element))
+							break;
+					}
+					return element;
+				}
+				auto element = _names ? interned (firstChild (parent, nullptr), name, ixStep) : firstChild (parent, static_cast<const char *> (name));
+				if (auto position = _xpath .Position (ixStep))
+				{
+					for (; element; element = sibling (element, name, ixStep))
+					{
+						if (match (ixStep, element) && --position == 0)
+							break;
+					}
+				}
+				return element;
+			}
+
+			XE * next (XE * element, const void * name, size_t ixStep) const
+			{
+				if (_xpath .Position (ixStep) || _xpath .Last (ixStep))
+					return nullptr;
+				return sibling (element, name, ixStep);
+			}
+
+			XE * sibling (XE * element, const void * name, size_t ixStep) const
+			{
+				if (!_names)
+					return nextSibling (element, static_cast<const char *> (name));
+				return interned (nextSibling (element, nullptr), name, ixStep);
+			}
+
+			bool positioned (const XMLElement * element, const void * name, size_t ixStep) const
+			{
+				// element, which matches the step, is at the position the step selects among its matching siblings
+				auto matches = [&] (const XMLElement * sibling) { return named (sibling, name, ixStep) && match (ixStep, sibling); };
+				if (_xpath .Last (ixStep))
+				{
+					for (auto sibling = element -> NextSiblingElement(); sibling; sibling = sibling -> NextSiblingElement())
+					{
+						if (matches (sibling))
+							return false;
+					}
+				}
+				else if (auto position = _xpath .Position (ixStep))
+				{
+					for (auto sibling = element -> PreviousSiblingElement(); sibling; sibling = sibling -> PreviousSiblingElement())
+					{
+						if (matches (sibling) && --position == 0)
+							return false;
+					}
+					return position == 1;
+				}
+				return true;
+			}
+
+			XE * interned (XE * element, const void * name, size_t ixStep) const
+			{
+				// skip to the next element with interned name
+				while (element && !named (element, name, ixStep))
+				{
+					count (&QueryStats::skipped);
+					element = nextSibling (element, nullptr);
+				}
+				return element;
+			}
+
+			// a scanned element, rejected on name when it isn't named by the last step
+			void visit (const XMLElement * element) const
+			{
+				auto level = _depth - 1;
+				count (&QueryStats::visited);
+				count (&QueryStats::skipped, !named (element, branch() [level] .name, _firstStep + level));
+			}
+
+			// tinyxml2 moves past elements with other names itself, when tracing we move one element at a time to count them
+			XE * firstChild (XE * parent, const char * name) const
+			{
+				if (!tracing())
+					return parent -> FirstChildElement (name);
+				return along (parent -> FirstChildElement(), name, [] (XE * element) { return element -> NextSiblingElement(); });
+			}
+			XE * lastChild (XE * parent, const char * name) const
+			{
+				if (!tracing())
+					return parent -> LastChildElement (name);
+				return along (parent -> LastChildElement(), name, [] (XE * element) { return element -> PreviousSiblingElement(); });
+			}
+			XE * nextSibling (XE * element, const char * name) const
+			{
+				if (!tracing())
+					return element -> NextSiblingElement (name);
+				return along (element -> NextSiblingElement(), name, [] (XE * element) { return element -> NextSiblingElement(); });
+			}
+			XE * previousSibling (XE * element, const char * name) const
+			{
+				if (!tracing())
+					return element -> PreviousSiblingElement (name);
+				return along (element -> PreviousSiblingElement(), name, [] (XE * element) { return element -> PreviousSiblingElement(); });
+			}
+			template <typename F> XE * along (XE * element, const char * name, F move) const
+			{
+				for (; element; element = move (element))
+				{
+					count (&QueryStats::visited);
+					if (!name || strcmp (element -> Name(), name) == 0)
+						break;
+					count (&QueryStats::skipped);
+				}
+				return element;
+			}
+
+			// count for the query and for its path when tracing, compiled to nothing without TIXML2EX_QUERY_STATS
+			void count ([[maybe_unused]] std::atomic<uint64_t> QueryStats::* counter, [[maybe_unused]] uint64_t n = 1) const
+			{
+#if defined (TIXML2EX_QUERY_STATS)
+				if (_trace .query)
+					(_trace .query ->* counter) .fetch_add (n, std::memory_order_relaxed);
+				if (_trace .path)
+					(_trace .path ->* counter) .fetch_add (n, std::memory_order_relaxed);
+#endif
+			}
+			bool tracing() const
+			{
+#if defined (TIXML2EX_QUERY_STATS)
+				return _trace .query || _trace .path;
+#else
+				return false;
+#endif
+			}
+
+			struct Timed
+			{
+				// adds the time from construction to destruction to the query's time
+#if defined (TIXML2EX_QUERY_STATS)
+				explicit Timed (const ElementIterator & iter) : iter (iter), start (iter .tracing() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point {}) {}
+				~Timed()
+				{
+					if (iter .tracing())
+						iter .count (&QueryStats::nanoseconds, (uint64_t) std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now() - start) .count());
+				}
+				const ElementIterator & iter;
+				std::chrono::steady_clock::time_point start;
+#else
+				explicit Timed (const ElementIterator &) {}
+#endif
+			};
+
+			struct Level
+			{
+				XE * element;
+				const void * name;	// element name to match, interned when matching with a name table, or nullptr for any element
+			};
+
+			const Level * branch() const { return _depth <= localDepth ? _local : _deep .data(); }
+			Level * branch() { return _depth <= localDepth ? _local : _deep .data(); }
+
+		private:
+			// selection branches up to localDepth are held within the iterator, so that constructing,
+			// copying and comparing iterators does not allocate, the compiled path is shared
+			static constexpr size_t localDepth = 8;
+
+			XPath _xpath;	// keeps the compiled path referred to by the selection branch alive
+			const NameTable * _names {nullptr};
+			size_t _firstStep {0};	// step of path matched at top of branch
+			size_t _depth {0};
+			XE * _current {nullptr};	// selected element, bottom of branch
+			size_t _scanLevel {0};	// levels from here down are matched by scanning candidates rather than walking the branch
+			const XMLNode * _top {nullptr};	// node scanned candidates must descend from
+			const std::vector<XMLElement *> * _candidates {nullptr};
+			size_t _ixCandidate {0};
+			size_t _remaining {0};	// with a limit, elements left to select including the current one, 0 for no limit
+			Level _local [localDepth] {};
+			std::vector<Level> _deep;
+#if defined (TIXML2EX_QUERY_STATS)
+			QueryTrace _trace;
+#endif
+
+			template <typename> friend class Selector;
+		};	// ElementIterator
+
+
+		inline ElementIterator<XMLElement> begin (XMLElement * parent)
+		{
+			if (!parent)
+				throw XmlException ("null element"s);
+			return ElementIterator<XMLElement> (parent -> FirstChildElement());
+		}
+
+
+		inline ElementIterator<XMLElement> end (XMLElement *)
+		{
+			return ElementIterator<XMLElement>();
+		}
+
+
+		inline ElementIterator<const XMLElement> begin (const XMLElement * parent)
+		{
+			if (!parent)
+				throw XmlException ("null element"s);
+			return ElementIterator<const XMLElement> (parent -> FirstChildElement());
+		}
+
+
+		inline ElementIterator<const XMLElement> end (const XMLElement *)
+		{
+			return ElementIterator<const XMLElement>();
+		}
+
+
+		inline ElementIterator<const XMLElement> cbegin (const XMLElement * parent)
+		{
+			return begin (parent);
+		}
+
+
+		inline ElementIterator<const XMLElement> cend (const XMLElement * e)
+		{
+			return end (e);
+		}
+
+
+		template <typename XE>
+		class Selector
+		{
+			// select child elements along XPath-style path for iteration
+		public:
+			Selector (XE * base, std::string_view xpath) : _base (base), _xpath (xpath) {}
+			Selector (XE * base, XPath xpath) : _base (base), _xpath (std::move (xpath)) {}
+			Selector (XE * base, XPath xpath, const NameTable & names) : _base (base), _xpath (std::move (xpath)), _names (&names) {}
+			Selector (XE * base, XPath xpath, const DocumentIndex & index) : _base (base), _xpath (std::move (xpath)), _index (&index) {}
+			Selector (XE * base, XPath xpath, const AttributeIndex & keys) : _base (base), _xpath (std::move (xpath)), _keys (&keys) {}
+
+			// select at most limit elements after skipping offset elements, traversal stops as soon as the window is complete
+			Selector Offset (size_t offset) const
+			{
+				Selector selector (*this);
+				selector ._offset = offset;
+				return selector;
+			}
+			Selector Limit (size_t limit) const
+			{
+				Selector selector (*this);
+				selector ._limit = limit;
+				return selector;
+			}
+
+			// count what iterating the selection does, in stats or, by path, in the registry
+			// only when compiled with TIXML2EX_QUERY_STATS defined, otherwise the selection is unchanged
+			Selector Trace (QueryStats & stats) const
+			{
+				Selector selector (*this);
+				selector ._stats = &stats;
+				return selector;
+			}
+			Selector Trace (QueryRegistry & registry) const
+			{
+				Selector selector (*this);
+				selector ._registry = &registry;
+				return selector;
+			}
+
+			bool Windowed() const { return _offset || _limit; }
+			const XPath & Path() const { return _xpath; }
+
+			// split the selection after step, into the selection of the elements matching the path up to step
+			// and the selection of the rest of the path below one of those elements
+			// the rest of the path is walked from each element, it does not use a DocumentIndex
+			Selector Head (size_t step) const
+			{
+				Selector selector (*this);
+				selector ._xpath = _xpath .Prefix (step + 1);
+				selector ._offset = 0;
+				selector ._limit .reset();
+				return selector;
+			}
+			Selector Tail (XE * element, size_t step) const
+			{
+				Selector selector (element, _xpath .Suffix (step + 1));
+				selector ._names = _names;
+				selector ._keys = _keys;
+				selector ._stats = _stats;
+				selector ._registry = _registry;
+				return selector;
+			}
+
+			ElementIterator<XE> begin() const
+			{
+				if (_xpath .Empty() || !_base || _limit == size_t {0})
+					return end();
+				if (_names && &_names -> Document() != _base -> GetDocument())
+					throw XmlException ("name table is not for the document"s);
+				if (_index && &_index -> Document() != _base -> GetDocument())
+					throw XmlException ("document index is not for the document"s);
+				if (_keys && &_keys -> Document() != _base -> GetDocument())
+					throw XmlException ("attribute index is not for the document"s);
+
+				ElementIterator<XE> iter (_base, _xpath, _names, _index, _keys, trace());
+				for (auto offset = _offset; offset > 0 && *iter; --offset)
+					++iter;
+				if (_limit)
+					iter ._remaining = *_limit;
+				return iter;
+			};
+
+			ElementIterator<XE> end() const
+			{
+				return ElementIterator<XE>();	// an empty iterator that will return a null XMLElement
+			};
+
+		private:
+			QueryTrace trace() const
+			{
+				QueryTrace trace {_stats, nullptr};
+				if constexpr (query_stats_enabled)
+				{
+					if (auto registry = _registry ? _registry : QueryRegistry::Global() .Enabled() ? &QueryRegistry::Global() : nullptr)
+						trace .path = &registry -> Stats (_xpath);
+				}
+				return trace;
+			}
+
+			XE * _base;
+			XPath _xpath;
+			const NameTable * _names {nullptr};
+			const DocumentIndex * _index {nullptr};
+			const AttributeIndex * _keys {nullptr};
+			size_t _offset {0};
+			std::optional<size_t> _limit;
+			QueryStats * _stats {nullptr};
+			QueryRegistry * _registry {nullptr};
+		};	// Selector
+
+
+		// helper functions to return appropriate const / non-const Selector
+		// xpath may be a std::string, a string literal or a std::string_view, it is parsed in place
+		inline Selector<XMLElement> selection (XMLElement * base, std::string_view xpath)
+		{
+			return Selector<XMLElement> (base, xpath);
+		}
+
+		inline Selector<const XMLElement> selection (const XMLElement * base, std::string_view xpath)
+		{
+			return Selector<const XMLElement> (base, xpath);
+		}
+
+		inline Selector<XMLElement> selection (XMLDocument & doc, std::string_view xpath)
+		{
+			return Selector<XMLElement> (doc .RootElement(), XPath (xpath) .FromDocument());
+		}
+
+		inline Selector<const XMLElement> selection (const XMLDocument & doc, std::string_view xpath)
+		{
+			return Selector<const XMLElement> (doc .RootElement(), XPath (xpath) .FromDocument());
+		}
+
+		// compiled XPath selections, paths applied to a document are always taken from the document
+		inline Selector<XMLElement> selection (XMLElement * base, const XPath & xpath)
+		{
+			return Selector<XMLElement> (base, xpath);
+		}
+
+		inline Selector<const XMLElement> selection (const XMLElement * base, const XPath & xpath)
+		{
+			return Selector<const XMLElement> (base, xpath);
+		}
+
+		inline Selector<XMLElement> selection (XMLDocument & doc, const XPath & xpath)
+		{
+			return Selector<XMLElement> (doc .RootElement(), xpath .FromDocument());
+		}
+
+		inline Selector<const XMLElement> selection (const XMLDocument & doc, const XPath & xpath)
+		{
+			return Selector<const XMLElement> (doc .RootElement(), xpath .FromDocument());
+		}
+
+		// selections matching element names against the interned names of a NameTable built over the document
+		inline Selector<XMLElement> selection (XMLElement * base, const XPath & xpath, const NameTable & names)
+		{
+			return Selector<XMLElement> (base, xpath, names);
+		}
+
+		inline Selector<const XMLElement> selection (const XMLElement * base, const XPath & xpath, const NameTable & names)
+		{
+			return Selector<const XMLElement> (base, xpath, names);
+		}
+
+		inline Selector<XMLElement> selection (XMLDocument & doc, const XPath & xpath, const NameTable & names)
+		{
+			return Selector<XMLElement> (doc .RootElement(), xpath .FromDocument(), names);
+		}
+
+		inline Selector<const XMLElement> selection (const XMLDocument & doc, const XPath & xpath, const NameTable & names)
+		{
+			return Selector<const XMLElement> (doc .RootElement(), xpath .FromDocument(), names);
+		}
+
+		// selections visiting only the elements a DocumentIndex built over the document holds for the last step
+		inline Selector<XMLElement> selection (XMLElement * base, const XPath & xpath, const DocumentIndex & index)
+		{
+			return Selector<XMLElement> (base, xpath, index);
+		}
+
+		inline Selector<const XMLElement> selection (const XMLElement * base, const XPath & xpath, const DocumentIndex & index)
+		{
+			return Selector<const XMLElement> (base, xpath, index);
+		}
+
+		inline Selector<XMLElement> selection (XMLDocument & doc, const XPath & xpath, const DocumentIndex & index)
+		{
+			return Selector<XMLElement> (doc .RootElement(), xpath .FromDocument(), index);
+		}
+
+		inline Selector<const XMLElement> selection (const XMLDocument & doc, const XPath & xpath, const DocumentIndex & index)
+		{
+			return Selector<const XMLElement> (doc .RootElement(), xpath .FromDocument(), index);
+		}
+
+		// selections looking up the elements an AttributeIndex holds for the attribute value filtered on by the last step
+		inline Selector<XMLElement> selection (XMLElement * base, const XPath & xpath, const AttributeIndex & keys)
+		{
+			return Selector<XMLElement> (base, xpath, keys);
+		}
+
+		inline Selector<const XMLElement> selection (const XMLElement * base, const XPath & xpath, const AttributeIndex & keys)
+		{
+			return Selector<const XMLElement> (base, xpath, keys);
+		}
+
+		inline Selector<XMLElement> selection (XMLDocument & doc, const XPath & xpath, const AttributeIndex & keys)
+		{
+			return Selector<XMLElement> (doc .RootElement(), xpath .FromDocument(), keys);
+		}
+
+		inline Selector<const XMLElement> selection (const XMLDocument & doc, const XPath & xpath, const AttributeIndex & keys)
+		{
+			return Selector<const XMLElement> (doc .RootElement(), xpath .FromDocument(), keys);
+		}
+
+
+		// helper functions to find the first element (if any) below a base element matching the XPath
+		inline XMLElement * find_element (XMLElement * base, std::string_view xpath = {})
+		{
+			return *Selector<XMLElement> (base, xpath) .begin();
+		}
+
+
+		inline const XMLElement * find_element (const XMLElement * base, std::string_view xpath = {})
+		{
+			return *Selector<const XMLElement> (base, xpath) .begin();
+		}
+
+
+		inline XMLElement * find_element (XMLDocument & doc, std::string_view xpath = {})
+		{
+			return *Selector<XMLElement> (doc .RootElement(), XPath (xpath) .FromDocument()) .begin();
+		}
+
+		inline const XMLElement * find_element (const XMLDocument & doc, std::string_view xpath = {})
+		{
+			return *Selector<const XMLElement> (doc .RootElement(), XPath (xpath) .FromDocument()) .begin();
+		}
+
+
+		inline XMLElement * find_element (XMLElement * base, const XPath & xpath)
+		{
+			return *Selector<XMLElement> (base, xpath) .begin();
+		}
+
+		inline const XMLElement * find_element (const XMLElement * base, const XPath & xpath)
+		{
+			return *Selector<const XMLElement> (base, xpath) .begin();
+		}
+
+		inline XMLElement * find_element (XMLDocument & doc, const XPath & xpath)
+		{
+			return find_element (doc .RootElement(), xpath .FromDocument());
+		}
+
+		inline const XMLElement * find_element (const XMLDocument & doc, const XPath & xpath)
+		{
+			return find_element (doc .RootElement(), xpath .FromDocument());
+		}
+
+		inline XMLElement * find_element (XMLElement * base, const XPath & xpath, const NameTable & names)
+		{
+			return *selection (base, xpath, names) .begin();
+		}
+
+		inline const XMLElement * find_element (const XMLElement * base, const XPath & xpath, const NameTable & names)
+		{
+			return *selection (base, xpath, names) .begin();
+		}
+
+		inline XMLElement * find_element (XMLDocument & doc, const XPath & xpath, const NameTable & names)
+		{
+			return *selection (doc, xpath, names) .begin();
+		}
+
+		inline const XMLElement * find_element (const XMLDocument & doc, const XPath & xpath, const NameTable & names)
+		{
+			return *selection (doc, xpath, names) .begin();
+		}
+
+		inline XMLElement * find_element (XMLElement * base, const XPath & xpath, const DocumentIndex & index)
+		{
+			return *selection (base, xpath, index) .begin();
+		}
+
+		inline const XMLElement * find_element (const XMLElement * base, const XPath & xpath, const DocumentIndex & index)
+		{
+			return *selection (base, xpath, index) .begin();
+		}
+
+		inline XMLElement * find_element (XMLDocument & doc, const XPath & xpath, const DocumentIndex & index)
+		{
+			return *selection (doc, xpath, index) .begin();
+		}
+
+		inline const XMLElement * find_element (const XMLDocument & doc, const XPath & xpath, const DocumentIndex & index)
+		{
+			return *selection (doc, xpath, index) .begin();
+		}
+
+		inline XMLElement * find_element (XMLElement * base, const XPath & xpath, const AttributeIndex & keys)
+		{
+			return *selection (base, xpath, keys) .begin();
+		}
+
+		inline const XMLElement * find_element (const XMLElement * base, const XPath & xpath, const AttributeIndex & keys)
+		{
+			return *selection (base, xpath, keys) .begin();
+		}
+
+		inline XMLElement * find_element (XMLDocument & doc, const XPath & xpath, const AttributeIndex & keys)
+		{
+			return *selection (doc, xpath, keys) .begin();
+		}
+
+		inline const XMLElement * find_element (const XMLDocument & doc, const XPath & xpath, const AttributeIndex & keys)
+		{
+			return *selection (doc, xpath, keys) .begin();
+		}
+
+
+		class SelectionCache
+		{
+			// opt-in cache of the elements selected from a document, keyed on the compiled path and the element it is applied to
+			// the cache has a generation, which append_element, prepend_element, insert_next_element, ElementAppender and xcopy advance;
+			// a selection made in an earlier generation is made again when next asked for
+			// call Invalidate() after other edits, including setting or deleting attributes and deleting elements
+			// paths are the same when they share the compiled path, as copies of an XPath do, a path compiled again is cached again
+			// the cache holds at most capacity selections, dropping those from earlier generations first, then any
+			// selecting from any number of threads is safe while the document is not being changed, selections not in the cache
+			// are made one at a time since tinyxml2 writes to the document when it first reads a name or value
+		public:
+			using Elements = std::shared_ptr<const std::vector<XMLElement *>>;
+
+			explicit SelectionCache (XMLDocument & doc, size_t capacity = 1024) : _doc (doc), _capacity (std::max <size_t> (capacity, 1))
+			{
+				auto & registry = documents();
+				std::unique_lock<std::shared_mutex> lock (registry .mutex);
+				if (!registry .caches .emplace (&doc, this) .second)
+					throw XmlException ("document already has a selection cache"s);
+				++registry .count;
+			}
+			~SelectionCache()
+			{
+				auto & registry = documents();
+				std::unique_lock<std::shared_mutex> lock (registry .mutex);
+				registry .caches .erase (&_doc);
+				--registry .count;
+			}
+			SelectionCache (const SelectionCache &) = delete;
+			SelectionCache & operator = (const SelectionCache &) = delete;
+
+			// the elements selected by xpath from base, which must be in the document of the cache, or from the document as selection (doc, xpath)
+			Elements Select (XMLElement * base, const XPath & xpath)
+			{
+				if (!base || xpath .Empty())
+					return _none;
+				// the cache is advanced only by edits to its own document
+				if (base -> GetDocument() != &_doc)
+					throw XmlException ("selection cache is not for the document"s);
+				Key key {xpath ._steps, xpath ._nSteps, xpath ._absolute, base};
+				auto generation = _generation .load();
+				{
+					std::shared_lock<std::shared_mutex> lock (_mutex);
+					auto ix = _entries .find (key);
+					if (ix != _entries .end() && ix -> second .generation == generation)
+					{
+						++_hits;
+						return ix -> second .elements;
+					}
+				}
+				std::unique_lock<std::shared_mutex> lock (_mutex);
+				auto ix = _entries .find (key);
+				if (ix != _entries .end() && ix -> second .generation == generation)
+				{
+					// made by another thread while this one waited
+					++_hits;
+					return ix -> second .elements;
+				}
+				++_misses;
+				auto elements = std::make_shared<std::vector<XMLElement *>>();
+				for (auto element : selection (base, xpath))
+					elements -> push_back (element);
+				// the entry keeps the compiled path, so that no other path can be compiled in its place while it is cached
+				Elements selected = std::move (elements);
+				_entries .insert_or_assign (key, Entry {xpath, generation, selected});
+				evict (key, generation);
+				return selected;
+			}
+			Elements Select (const XPath & xpath) { return Select (_doc .RootElement(), xpath .FromDocument()); }
 
+			// first element selected, or nullptr
+			XMLElement * Find (XMLElement * base, const XPath & xpath)
+			{
+				auto elements = Select (base, xpath);
+				return elements -> empty() ? nullptr : elements -> front();
+			}
+			XMLElement * Find (const XPath & xpath) { return Find (_doc .RootElement(), xpath .FromDocument()); }
 
-		template <typename XE> using element_path_location_t = std::pair<ElementProperties, XE *>;
-		template <typename XE> using element_path_t = std::list<element_path_location_t<XE>>;
-		template <typename XE> using element_path_iterator_t = typename element_path_t<XE>::iterator;
+			// start a new generation, so that every selection is made again
+			void Invalidate() { ++_generation; }
+			// forget all selections
+			void Clear()
+			{
+				std::unique_lock<std::shared_mutex> lock (_mutex);
+				_entries .clear();
+			}
 
+			uint64_t Generation() const { return _generation .load(); }
+			size_t Size() const
+			{
+				std::shared_lock<std::shared_mutex> lock (_mutex);
+				return _entries .size();
+			}
+			// selections answered from the cache and those made, including those made again in a new generation
+			size_t Hits() const { return _hits .load(); }
+			size_t Misses() const { return _misses .load(); }
 
-		template <typename XE> inline element_path_t<XE> element_path_from_xpath (XE * root, const std::string & xpath)
-		{
-			if (!root)
-				throw XmlException ("null element"s);
+			// the cache of the document of node, if any
+			static SelectionCache * Of (const XMLNode * node)
+			{
+				auto & registry = documents();
+				if (registry .count == 0)
+					return nullptr;
+				std::shared_lock<std::shared_mutex> lock (registry .mutex);
+				auto ix = registry .caches .find (node -> GetDocument());
+				return ix != registry .caches .end() ? ix -> second : nullptr;
+			}
 
-			element_path_t<XE> ep;
+		private:
+			struct Key
+			{
+				const XPathStep * steps;
+				size_t nSteps;
+				bool absolute;
+				const XMLElement * base;
 
-			// split the path
-			size_t start = 0;
-			size_t pos;
-			// set element at head of selection branch
-			//	if path starts with '/' then it is relative to document, otherwise relative to element passed in
-			// first element in selection branch is the root and only children of the root are considered
-			// for document-based paths, this works because there can only be one document element
-			if (!xpath.empty() && xpath[0] == '/')
+				bool operator == (const Key & key) const { return steps == key .steps && nSteps == key .nSteps && absolute == key .absolute && base == key .base; }
+			};
+			struct Hash
 			{
-				// document is not an element so needs special handling
-				// advance to the actual document element
-				// note that document element must still appear in path, so we have to step over it
-				++start;
-				if ((pos = xpath .find ('/', start)) != std::string::npos)
+				size_t operator () (const Key & key) const
 				{
-					auto filter = ElementProperties (xpath .substr (start, pos - start));
-					auto element = root -> GetDocument() -> RootElement();
-					if (element && !filter .Name() .empty())
-					{
-						if (filter .Name() != std::string (element -> Name()))
-							throw XmlException ("document element name mismatch"s);
-					}
-					ep .emplace_back (std::make_pair (filter, element));
-					start = pos + 1;
+					auto hash = std::hash<const void *>() (key .steps);
+					hash = hash * 31 + std::hash<const void *>() (key .base);
+					return hash * 31 + key .nSteps * 2 + key .absolute;
 				}
+			};
+			struct Entry
+			{
+				XPath xpath;
+				uint64_t generation;
+				Elements elements;
+			};
+
+			struct Registry
+			{
+				std::shared_mutex mutex;
+				std::unordered_map<const XMLDocument *, SelectionCache *> caches;
+				std::atomic<size_t> count {0};	// so that documents without a cache need not take the lock
+			};
+
+			static Registry & documents()
+			{
+				static Registry registry;
+				return registry;
 			}
-			else
-				ep .emplace_back (std::make_pair (ElementProperties (root -> Name()), root));
 
-			// continue with other elements along path
-			while ((pos = xpath .find ('/', start)) != std::string::npos)
+			void evict (const Key & kept, uint64_t generation)
 			{
-				ep .emplace_back (std::make_pair (ElementProperties (xpath .substr (start, pos - start)), nullptr));
-				start = pos + 1;
+				// once a generation, or when full, drop the selections of earlier generations, then any but kept while still full
+				if (_swept == generation && _entries .size() <= _capacity)
+					return;
+				_swept = generation;
+				for (auto ix = _entries .begin(); ix != _entries .end(); )
+					ix = ix -> second .generation != generation ? _entries .erase (ix) : std::next (ix);
+				for (auto ix = _entries .begin(); _entries .size() > _capacity; )
+					ix = ix -> first == kept ? std::next (ix) : _entries .erase (ix);
 			}
-			// and the final element
-			ep .emplace_back (std::make_pair (ElementProperties (xpath .substr (start, pos - start)), nullptr));
 
-			return ep;
+			XMLDocument & _doc;
+			const size_t _capacity;
+			uint64_t _swept {0};	// generation of the entries kept when they were last dropped
+			std::atomic<uint64_t> _generation {0};
+			std::atomic<size_t> _hits {0};
+			std::atomic<size_t> _misses {0};
+			mutable std::shared_mutex _mutex;
+			std::unordered_map<Key, Entry, Hash> _entries;
+			const Elements _none {std::make_shared<const std::vector<XMLElement *>>()};
+		};	// SelectionCache
+
+
+		inline XMLElement * find_element (XMLElement * base, const XPath & xpath, SelectionCache & cache)
+		{
+			return cache .Find (base, xpath);
+		}
+
+		inline XMLElement * find_element (XMLDocument & doc, const XPath & xpath, SelectionCache & cache)
+		{
+			if (SelectionCache::Of (&doc) != &cache)
+				throw XmlException ("selection cache is not for the document"s);
+			return cache .Find (xpath);
 		}
 
 
-		template <typename XE> inline element_path_t<XE> element_path_from_element (XE * e)
+		// throw the error of a document that failed to parse xml
+		[[noreturn]] inline void throw_parse_error (const XMLDocument & doc, std::string_view xml)
 		{
-			return {std::make_pair (ElementProperties(), e)};
+			auto line = doc .ErrorLineNum();
+			size_t offset = 0;
+			for (auto n = line; n > 1 && offset < xml .size(); --n)
+			{
+				auto eol = xml .find ('\n', offset);
+				offset = eol == std::string_view::npos ? xml .size() : eol + 1;
+			}
+			auto description = "error in XML"s;
+			if (line > 0)
+				description += " at line "s + std::to_string (line) + " (offset "s + std::to_string (offset) + ")"s;
+			if (auto message = doc .ErrorStr(); message && *message)
+				description += " : "s + message;
+			throw XmlParseError (description, doc .ErrorID(), line, offset);
 		}
 
 
-		template <typename XE>
-		class ElementIterator
+		// load XML document from string buffer, which need not be null terminated
+		inline std::unique_ptr <XMLDocument> load_document (std::string_view xml)
 		{
-		public:
-			// iterator_traits
-			using iterator_category = std::input_iterator_tag;
-			using value_type = XE;
-			using difference_type = std::ptrdiff_t;
-			using pointer = XE *;
-			using reference = XE &;
+			auto doc = std::make_unique <XMLDocument>();
+			if (doc -> Parse (xml .data(), xml .size()) != XML_SUCCESS)
+				throw_parse_error (*doc, xml);
+			return doc;
+		}
 
 
+		class DocumentPool
+		{
+			// documents for reuse, tinyxml2 keeps the memory pools of a cleared document for its next parse
+			// documents are returned to the pool when released, cleared, and kept unless capacity are already idle
+			// the pool is thread-safe and must outlive the documents it hands out
 		public:
-			ElementIterator() : _selectionPath (element_path_from_element (static_cast<XE *>(nullptr))) {}
-			ElementIterator (XE * origin) : _selectionPath (element_path_from_element (origin)) {}
-			ElementIterator (XE * origin, const std::string & xpath)
-				: _selectionPath (element_path_from_xpath (origin, xpath))
+			struct Return
 			{
-				if (_selectionPath .empty())
-					throw XmlException ("selection xpath is empty - logic error");
+				DocumentPool * pool;
+				void operator() (XMLDocument * doc) const { pool -> release (doc); }
+			};
+			using Document = std::unique_ptr <XMLDocument, Return>;
 
-				// _selectionPath must have at least one element which is the origin of all branches considered
-				// only children of the origin are considered
-				// on construction the origin element must be a valid XMLElement
-				// elements in the remainder of the path are initially null
-				// descend and initialise first matching branch (if any)
-				descend (_selectionPath .begin());
-				// remove the origin from the list so that iteration is only over child elements
-				_selectionPath .pop_front();
-			}
-			XE * operator *() const { return !_selectionPath .empty() ? _selectionPath .back() .second : nullptr; }
-			bool operator == (const ElementIterator & iter) const { return *iter == _selectionPath .back() .second; }
-			bool operator != (const ElementIterator & iter) const { return ! operator == (iter); }
-			ElementIterator & operator ++()
-			{
-				// to get here we must have found at least one matching element
-				// selection branch contains the complete element path
-#if !defined (NDEBUG)
-				for (auto const & pe : _selectionPath)
-					assert (pe .second);
-#endif
-				// start at the bottom with the current element
-				traverse (--_selectionPath .end());
-				return *this;
-			}
+			explicit DocumentPool (size_t capacity = 16) : _capacity (capacity) { _idle .reserve (capacity); }	// so returning a document never allocates
+			DocumentPool (const DocumentPool &) = delete;
+			DocumentPool & operator = (const DocumentPool &) = delete;
 
-		private:
-			bool descend (element_path_iterator_t<XE> ixSel)
+			// an empty document
+			Document Acquire()
 			{
-				// recursively descend selection branch of matching elements
-				if (!ixSel -> second)
-					return false;
-				auto parentElement = ixSel -> second;
-
-				if (++ixSel == _selectionPath .end())
-					return true;	// we've found the first matching element
-
-				ixSel -> second = parentElement -> FirstChildElement (ixSel -> first .Name() .empty() ? nullptr : ixSel -> first .Name() .c_str());
-				while (ixSel -> second)
 				{
-					if (ixSel -> first .Match (ixSel -> second))
+					std::lock_guard<std::mutex> lock (_mutex);
+					if (!_idle .empty())
 					{
-						if (descend (ixSel))
-							return true;
+						Document doc {_idle .back() .release(), Return {this}};
+						_idle .pop_back();
+						return doc;
 					}
-					// move sideways
-					ixSel -> second = ixSel -> second -> NextSiblingElement (ixSel -> first .Name() .empty() ? nullptr : ixSel -> first .Name() .c_str());
 				}
-				return false;	// no matching elements at this depth
+				return Document {new XMLDocument, Return {this}};
 			}
 
-			void traverse (element_path_iterator_t<XE> ixSel)
+			// as load_document
+			Document Load (std::string_view xml)
 			{
-				// to find next element we can go sideways or up and then down
-				// traverse() does the moves across the xml tree, descend() then explores each potential new branch
-				// note that this method can only be called once the selection has been initialised
-				while ((ixSel -> second = ixSel -> second -> NextSiblingElement (ixSel -> first .Name() .empty() ? nullptr : ixSel -> first .Name() .c_str())))
-				{
-					if (ixSel -> first .Match (ixSel -> second))
-					{
-						if (descend (ixSel))
-							return;
-					}
-				}
-				// no siblings or sibling branches match, go up a level (unless already at origin)
-				if (ixSel != _selectionPath .begin())
-					traverse (--ixSel);
+				auto doc = Acquire();
+				if (doc -> Parse (xml .data(), xml .size()) != XML_SUCCESS)
+					throw_parse_error (*doc, xml);
+				return doc;
+			}
+
+			size_t Idle() const
+			{
+				std::lock_guard<std::mutex> lock (_mutex);
+				return _idle .size();
 			}
 
 		private:
-			element_path_t<XE> _selectionPath;
-		};	// ElementIterator
+			void release (XMLDocument * doc)
+			{
+				std::unique_ptr <XMLDocument> returned {doc};
+				returned -> Clear();
+				std::lock_guard<std::mutex> lock (_mutex);
+				if (_idle .size() < _capacity)
+					_idle .push_back (std::move (returned));
+			}
 
+			size_t _capacity;
+			mutable std::mutex _mutex;
+			std::vector<std::unique_ptr <XMLDocument>> _idle;
+		};	// DocumentPool
 
-		inline ElementIterator<XMLElement> begin (XMLElement * parent)
+
+		// find the first child element of given element (if any) with (option) element type name
+		// todo: this is possibly redundant - use find_element()
+		inline const XMLElement * first_child_element (const XMLNode * parent, const std::string & name = ""s)
 		{
 			if (!parent)
 				throw XmlException ("null element"s);
-			return ElementIterator<XMLElement> (parent -> FirstChildElement());
+
+			return parent -> FirstChildElement (!name .empty() ? name .c_str() : nullptr);
 		}
 
 
-		inline ElementIterator<XMLElement> end (XMLElement *)
+		// helper function to get atribute value as a string, blank if attribute missing
+		inline std::string attribute_value (const XMLElement * element, const std::string & name, bool throwIfUnknown = false)
 		{
-			return ElementIterator<XMLElement>();
+			if (!element)
+				throw XmlException ("null element"s);
+
+			if (name .empty())
+				throw XmlException ("missing attribute name"s);
+
+			if (auto value = element -> Attribute (name .c_str()))
+				return std::string (value);
+
+			if (!throwIfUnknown)
+				return ""s;
+			else
+				throw XmlException ("attribute not present"s);
 		}
 
 
-		inline ElementIterator<const XMLElement> begin (const XMLElement * parent)
+		// helper function to get element text as a string, blank if none
+		inline std::string text (const XMLElement * element)
 		{
-			if (!parent)
+			if (!element)
 				throw XmlException ("null element"s);
-			return ElementIterator<const XMLElement> (parent -> FirstChildElement());
+
+			if (auto value = element -> GetText())
+				return std::string (value);
+			else
+				return ""s;
 		}
 
 
-		inline ElementIterator<const XMLElement> end (const XMLElement *)
+		// helper functions to view attribute value and element text in place, without copying
+		// the view refers to the document's own buffer and is valid until the element is modified or deleted
+		inline std::string_view attribute_view (const XMLElement * element, const char * name, bool throwIfUnknown = false)
 		{
-			return ElementIterator<const XMLElement>();
-		}
+			if (!element)
+				throw XmlException ("null element"s);
 
+			if (!name || !*name)
+				throw XmlException ("missing attribute name"s);
 
-		inline ElementIterator<const XMLElement> cbegin (const XMLElement * parent)
-		{
-			return begin (parent);
-		}
+			if (auto value = element -> Attribute (name))
+				return value;
 
+			if (!throwIfUnknown)
+				return {};
+			else
+				throw XmlException ("attribute not present"s);
+		}
 
-		inline ElementIterator<const XMLElement> cend (const XMLElement * e)
+		inline std::string_view attribute_view (const XMLElement * element, const std::string & name, bool throwIfUnknown = false)
 		{
-			return end (e);
+			return attribute_view (element, name .c_str(), throwIfUnknown);
 		}
 
 
-		template <typename XE>
-		class Selector
+		inline std::string_view text_view (const XMLElement * element)
 		{
-			// select child elements along XPath-style path for iteration
-		public:
-			Selector (XE * base, std::string xpath) : _base (base), _xpath (xpath) {}
-
-			ElementIterator<XE> begin() const
-			{
-				if (!_xpath .empty() && _base)
-					return ElementIterator<XE> (_base, _xpath);
-				else
-					return end();
-			};
+			if (!element)
+				throw XmlException ("null element"s);
 
-			ElementIterator<XE> end() const
-			{
-				return ElementIterator<XE>();	// an empty iterator that will return a null XMLElement
-			};
+			if (auto value = element -> GetText())
+				return value;
+			else
+				return {};
+		}
 
-		private:
-			XE * _base;
-			std::string _xpath;
-		};	// Selector
 
+		// conversion of attribute values and element text to type T, working directly on tinyxml2's own strings
+		// specialise ValueConverter for user types, Convert returns false if the value cannot be converted, e.g.
+		//		template <> struct tinyxml2::ValueConverter<Colour> { static bool Convert (std::string_view value, Colour & result); };
+		template <typename T, typename Enable = void>
+		struct ValueConverter;
 
-		// helper functions to return appropriate const / non-const Selector
-		inline Selector<XMLElement> selection (XMLElement * base, std::string xpath)
+		// numbers and booleans ignore leading and trailing whitespace
+		inline std::string_view trim_whitespace (std::string_view value)
 		{
-			return Selector<XMLElement> (base, xpath);
+			auto first = value .find_first_not_of (" \t\n\r");
+			if (first == std::string_view::npos)
+				return {};
+			return value .substr (first, value .find_last_not_of (" \t\n\r") - first + 1);
 		}
 
-		inline Selector<const XMLElement> selection (const XMLElement * base, std::string xpath)
+		template <typename T>
+		struct ValueConverter<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>>
 		{
-			return Selector<const XMLElement> (base, xpath);
-		}
+			static bool Convert (std::string_view value, T & result)
+			{
+				value = trim_whitespace (value);
+				if (value .size() > 1 && value [0] == '+')
+					value .remove_prefix (1);
+				auto last = value .data() + value .size();
+				auto [end, ec] = std::from_chars (value .data(), last, result);
+				return ec == std::errc() && end == last;
+			}
+		};
 
-		inline Selector<XMLElement> selection (XMLDocument & doc, std::string xpath)
+		template <>
+		struct ValueConverter<bool>
 		{
-			return Selector<XMLElement> (doc .RootElement(), (!xpath.empty() && xpath[0] == '/') ? xpath : '/' + xpath);
-		}
+			static bool Convert (std::string_view value, bool & result)
+			{
+				value = trim_whitespace (value);
+				if (value == "true" || value == "True" || value == "TRUE" || value == "1")
+					result = true;
+				else if (value == "false" || value == "False" || value == "FALSE" || value == "0")
+					result = false;
+				else
+					return false;
+				return true;
+			}
+		};
 
-		inline Selector<const XMLElement> selection (const XMLDocument & doc, std::string xpath)
+		template <>
+		struct ValueConverter<std::string_view>
 		{
-			return Selector<const XMLElement> (doc .RootElement(), (!xpath.empty() && xpath[0] == '/') ? xpath : '/' + xpath);
-		}
-
+			static bool Convert (std::string_view value, std::string_view & result) { result = value; return true; }
+		};
 
-		// helper functions to find the first element (if any) below a base element matching the XPath
-		inline XMLElement * find_element (XMLElement * base, std::string xpath = ""s)
+		template <>
+		struct ValueConverter<std::string>
 		{
-			return *Selector<XMLElement> (base, xpath) .begin();
-		}
+			static bool Convert (std::string_view value, std::string & result) { result = value; return true; }
+		};
 
 
-		inline const XMLElement * find_element (const XMLElement * base, std::string xpath = ""s)
+		template <typename T> struct is_optional : std::false_type {};
+		template <typename T> struct is_optional<std::optional<T>> : std::true_type {};
+
+		// convert value, which is null when absent, absence is an error unless T is std::optional
+		template <typename T> inline T convert_value (const char * value, const char * absent, const char * invalid)
 		{
-			return *Selector<const XMLElement> (base, xpath) .begin();
+			if constexpr (is_optional<T>::value)
+			{
+				if (!value)
+					return std::nullopt;
+				return convert_value<typename T::value_type> (value, absent, invalid);
+			}
+			else
+			{
+				if (!value)
+					throw XmlException (absent);
+				T result {};
+				if (!ValueConverter<T>::Convert (value, result))
+					throw XmlException (invalid);
+				return result;
+			}
 		}
 
 
-		inline XMLElement * find_element (XMLDocument & doc, std::string xpath = ""s)
+		// helper functions to get attribute value as type T
+		// throws if attribute is missing, unless T is std::optional or a default value is given, or if the value cannot be converted
+		// n.b. the view of a missing attribute or text is empty with null data, whereas an empty value is not null
+		template <typename T> inline T attribute_as (const XMLElement * element, const char * name)
 		{
-			return find_element (doc .RootElement(), (!xpath.empty() && xpath[0] == '/') ? xpath : '/' + xpath);
+			return convert_value<T> (attribute_view (element, name) .data(), "attribute not present", "unable to convert attribute value");
 		}
 
-		inline const XMLElement * find_element (const XMLDocument & doc, std::string xpath = ""s)
+		template <typename T> inline T attribute_as (const XMLElement * element, const std::string & name)
 		{
-			return find_element (doc .RootElement(), (!xpath.empty() && xpath[0] == '/') ? xpath : '/' + xpath);
+			return attribute_as<T> (element, name .c_str());
 		}
 
-
-		// load XML document from string buffer
-		inline std::unique_ptr <XMLDocument> load_document (const std::string & xmlString)
+		template <typename T> inline T attribute_as (const XMLElement * element, const char * name, const T & defaultValue)
 		{
-			auto doc = std::make_unique <XMLDocument>();
-			if (doc -> Parse (xmlString .c_str()) != XML_SUCCESS)
-				throw XmlException ("error in XML"s);
-			return doc;
+			auto value = attribute_view (element, name) .data();
+			return value ? convert_value<T> (value, "attribute not present", "unable to convert attribute value") : defaultValue;
 		}
 
-
-		// find the first child element of given element (if any) with (option) element type name
-		// todo: this is possibly redundant - use find_element()
-		inline const XMLElement * first_child_element (const XMLNode * parent, const std::string & name = ""s)
+		template <typename T> inline T attribute_as (const XMLElement * element, const std::string & name, const T & defaultValue)
 		{
-			if (!parent)
-				throw XmlException ("null element"s);
-
-			return parent -> FirstChildElement (!name .empty() ? name .c_str() : nullptr);
+			return attribute_as<T> (element, name .c_str(), defaultValue);
 		}
 
 
-		// helper function to get atribute value as a string, blank if attribute missing
-		inline std::string attribute_value (const XMLElement * element, const std::string & name, bool throwIfUnknown = false)
+		// helper functions to get element text as type T
+		// throws if element has no text, unless T is std::optional or a default value is given, or if the text cannot be converted
+		template <typename T> inline T text_as (const XMLElement * element)
 		{
-			if (!element)
-				throw XmlException ("null element"s);
-
-			if (name .empty())
-				throw XmlException ("missing attribute name"s);
-
-			if (auto value = element -> Attribute (name .c_str()))
-				return std::string (value);
-
-			if (!throwIfUnknown)
-				return ""s;
-			else
-				throw XmlException ("attribute not present"s);
+			return convert_value<T> (text_view (element) .data(), "element has no text", "unable to convert element text");
 		}
 
-
-		// helper function to get element text as a string, blank if none
-		inline std::string text (const XMLElement * element)
+		template <typename T> inline T text_as (const XMLElement * element, const T & defaultValue)
 		{
-			if (!element)
-				throw XmlException ("null element"s);
-
-			if (auto value = element -> GetText())
-				return std::string (value);
-			else
-				return ""s;
+			auto value = text_view (element) .data();
+			return value ? convert_value<T> (value, "element has no text", "unable to convert element text") : defaultValue;
 		}
 
 
 		// append / prepend element
 		// common method for all append / prepend element insertions
 		// todo: consider using std::initializer_list<AttributeNameValue> for attributes parameter
-		inline XMLElement * append_element (XMLElement * parent, const std::string & xpath, const attribute_list_t & attributes, const std::string & text, bool addAtBack)
+		inline XMLElement * append_element (XMLElement * parent, std::string_view xpath, const attribute_list_t & attributes, const std::string & text, bool addAtBack)
 		{
 			XMLElement * element {nullptr};
+			XMLElement * head {nullptr};	// first element of new branch
 			bool inserted {false};
 
-			element_path_t<XMLElement> branch {element_path_from_xpath (parent, xpath)};
+			XPath compiled (xpath);
+			size_t firstStep;
+			xpath_origin (parent, compiled, firstStep);
+			for (auto ixStep = firstStep; ixStep < compiled .Size(); ++ixStep)
+			{
+				if (compiled .Descendant (ixStep))
+					throw XmlException ("descendant step in element path"s);
+				if (compiled .Position (ixStep) || compiled .Last (ixStep))
+					throw XmlException ("positional filter in element path"s);
+			}
 			// add all the elements to create new branch
-			// first element in branch is the parent, so skip
-			for (auto be = ++branch .begin(); be != branch .end(); ++be)
+			for (auto ixStep = firstStep; ixStep < compiled .Size(); ++ixStep)
 			{
-				element = parent -> GetDocument() -> NewElement (be -> first .Name() .c_str());
+				element = parent -> GetDocument() -> NewElement (compiled .Name (ixStep));
 				if (!element)
 					break;
 				// and set element attributes from XPath data
-				be -> first .Update (element);
-				be -> second = element;
+				compiled .Update (ixStep, element);
 				// insert new element into hierarchy
 				auto last = parent -> LastChildElement();
 				if (addAtBack && last)
@@ -501,6 +2399,10 @@ namespace tinyxml2
 						inserted = parent -> InsertAfterChild (last, element) != nullptr;
 				else
 					inserted = parent -> InsertFirstChild (element) != nullptr;
+				if (!inserted)
+					break;
+				if (!head)
+					head = element;
 
 				parent = element;	// move along branch as it's built
 			}
@@ -511,13 +2413,19 @@ namespace tinyxml2
 					element -> SetAttribute (attr .Name() .c_str(), attr .Value() .c_str());
 				if (!text .empty())
 					element -> SetText (text .c_str());
+				if (auto keyed = AttributeIndex::Of (head))
+					keyed -> Insert (head);
+				if (auto cache = SelectionCache::Of (head))
+					cache -> Invalidate();
 				return element;
 			}
 			else
 			{
 				// failed, delete any elements we created
-				for (auto be = ++branch .begin(); be != branch .end(); ++be)
-					parent -> GetDocument() -> DeleteNode (be -> second);
+				if (element)
+					parent -> GetDocument() -> DeleteNode (element);
+				if (head)
+					parent -> GetDocument() -> DeleteNode (head);
 				throw XmlException ("unable to append element"s);
 			}
 			// always returns valid XMLElement on success, failures are exceptions
@@ -525,44 +2433,44 @@ namespace tinyxml2
 
 
 		// append family
-		inline XMLElement * append_element (XMLElement * parent, const std::string & xpath)
+		inline XMLElement * append_element (XMLElement * parent, std::string_view xpath)
 		{
 			return append_element (parent, xpath, {}, ""s, true);
 		}
 
-		inline XMLElement * append_element (XMLElement * parent, const std::string & xpath, const attribute_list_t &  attributes)
+		inline XMLElement * append_element (XMLElement * parent, std::string_view xpath, const attribute_list_t &  attributes)
 		{
 			return append_element (parent, xpath, attributes, ""s, true);
 		}
 
-		inline XMLElement * append_element (XMLElement * parent, const std::string & xpath, const std::string & text)
+		inline XMLElement * append_element (XMLElement * parent, std::string_view xpath, const std::string & text)
 		{
 			return append_element (parent, xpath, {}, text, true);
 		}
 
-		inline XMLElement * append_element (XMLElement * parent, const std::string & xpath, const attribute_list_t &  attributes, const std::string & text)
+		inline XMLElement * append_element (XMLElement * parent, std::string_view xpath, const attribute_list_t &  attributes, const std::string & text)
 		{
 			return append_element (parent, xpath, attributes, text, true);
 		}
 
 
 		// prepend family
-		inline XMLElement * prepend_element (XMLElement * parent, const std::string & xpath)
+		inline XMLElement * prepend_element (XMLElement * parent, std::string_view xpath)
 		{
 			return append_element (parent, xpath, {}, ""s, false);
 		}
 
-		inline XMLElement * prepend_element (XMLElement * parent, const std::string & xpath, const attribute_list_t &  attributes)
+		inline XMLElement * prepend_element (XMLElement * parent, std::string_view xpath, const attribute_list_t &  attributes)
 		{
 			return append_element (parent, xpath, attributes, ""s, false);
 		}
 
-		inline XMLElement * prepend_element (XMLElement * parent, const std::string & xpath, const std::string & text)
+		inline XMLElement * prepend_element (XMLElement * parent, std::string_view xpath, const std::string & text)
 		{
 			return append_element (parent, xpath, {}, text, false);
 		}
 
-		inline XMLElement * prepend_element (XMLElement * parent, const std::string & xpath, const attribute_list_t &  attributes, const std::string & text)
+		inline XMLElement * prepend_element (XMLElement * parent, std::string_view xpath, const attribute_list_t &  attributes, const std::string & text)
 		{
 			return append_element (parent, xpath, attributes, text, false);
 		}
@@ -589,6 +2497,10 @@ namespace tinyxml2
 					element -> SetAttribute (attr .Name() .c_str(), attr .Value() .c_str());
 				if (!text .empty())
 					element -> SetText (text .c_str());
+				if (auto keyed = AttributeIndex::Of (element))
+					keyed -> Insert (element);
+				if (auto cache = SelectionCache::Of (element))
+					cache -> Invalidate();
 				return element;
 			}
 			else
@@ -598,5 +2510,113 @@ namespace tinyxml2
 			}
 			// always returns valid XMLElement on success, failures are exceptions
 		}
+
+
+		class ElementAppender
+		{
+			// appends any number of branches built from a compiled path to a parent, as append_element would
+			// the path is checked once and the last branch appended is kept so that the next goes straight after it
+			// the parent must not be changed other than through the appender while it is in use
+		public:
+			ElementAppender (XMLElement * parent, const XPath & xpath) : _parent (parent), _xpath (xpath)
+			{
+				for (size_t ixStep = 0; ixStep < _xpath .Size(); ++ixStep)
+				{
+					if (_xpath .Descendant (ixStep))
+						throw XmlException ("descendant step in element path"s);
+					if (_xpath .Position (ixStep) || _xpath .Last (ixStep))
+						throw XmlException ("positional filter in element path"s);
+				}
+				xpath_origin (parent, _xpath, _firstStep);
+				if (_firstStep >= _xpath .Size())
+					throw XmlException ("empty element path"s);
+				_doc = parent -> GetDocument();
+				_last = parent -> LastChildElement();
+				_keyed = AttributeIndex::Of (parent);
+				_cache = SelectionCache::Of (parent);
+			}
+
+			// append a branch, calling set (element) on its final element to set its attributes and text, and return the final element
+			template <typename F>
+			XMLElement * Append (F set)
+			{
+				XMLElement * head {nullptr};
+				XMLNode * parent = _parent;
+				XMLElement * element {nullptr};
+				for (auto ixStep = _firstStep; ixStep < _xpath .Size(); ++ixStep)
+				{
+					element = _doc -> NewElement (_xpath .Name (ixStep));
+					_xpath .Update (ixStep, element);
+					if (!head)
+					{
+						// after the last element appended rather than any text following it, as append_element
+						head = element;
+						if (_last)
+							_parent -> InsertAfterChild (_last, element);
+						else
+							_parent -> InsertFirstChild (element);
+						_last = head;
+					}
+					else
+						parent -> InsertEndChild (element);
+					parent = element;
+				}
+				set (element);
+				if (_keyed)
+					_keyed -> Insert (head);
+				if (_cache)
+					_cache -> Invalidate();
+				return element;
+			}
+			XMLElement * Append() { return Append ([] (XMLElement *) {}); }
+
+		private:
+			XMLElement * _parent;
+			XPath _xpath;
+			size_t _firstStep {0};
+			XMLDocument * _doc {nullptr};
+			XMLElement * _last {nullptr};
+			AttributeIndex * _keyed {nullptr};
+			SelectionCache * _cache {nullptr};
+		};	// ElementAppender
+
+
+		inline void set_attribute (XMLElement * element, const AttributeNameValue & attribute)
+		{
+			element -> SetAttribute (attribute .Name() .c_str(), attribute .Value() .c_str());
+		}
+
+		inline const char * c_string (const char * text) { return text; }
+		inline const char * c_string (const std::string & text) { return text .c_str(); }
+
+		template <typename N, typename V> inline void set_attribute (XMLElement * element, const std::pair<N, V> & attribute)
+		{
+			element -> SetAttribute (c_string (attribute .first), c_string (attribute .second));
+		}
+
+
+		// append a branch built from xpath to parent for each of records, returning the final element of the last branch
+		// fn either sets the attributes and text of the final element, fn (record, element), or projects the record to attributes,
+		// fn (record), returning a range of AttributeNameValue or of name and value pairs
+		template <typename R, typename F>
+		inline XMLElement * append_elements (XMLElement * parent, const XPath & xpath, const R & records, F fn)
+		{
+			ElementAppender appender (parent, xpath);
+			XMLElement * element {nullptr};
+			for (auto const & record : records)
+			{
+				element = appender .Append ([&fn, &record] (XMLElement * element)
+				{
+					if constexpr (std::is_invocable_v<F &, decltype (record), XMLElement *>)
+						fn (record, element);
+					else
+					{
+						for (auto const & attribute : fn (record))
+							set_attribute (element, attribute);
+					}
+				});
+			}
+			return element;
+		}
 	}
 }
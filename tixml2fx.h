@@ -0,0 +1,590 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+tixml2fx.h implements loading XML documents from files
+files are mapped into memory and parsed in place rather than first being read into a buffer
+or, when a document is too large to hold, read in chunks and only the selected elements parsed
+it is separate from the base tinyxml2 extensions because it uses the operating system's file mapping
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <cstdint>
+#include <type_traits>
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#include <io.h>
+#include <fcntl.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#ifndef __TINYXML_EX__
+#include <tixml2ex.h>
+#endif // !__TINYXML_EX__
+
+namespace tinyxml2
+{
+	inline namespace tixml2ex
+	{
+		class MappedFile
+		{
+			// a file mapped read-only into memory, test before use as an empty or unreadable file isn't mapped
+		public:
+			static constexpr size_t LargeFile = 1 << 20;		// read ahead of the parser from files of this size or more
+
+			explicit MappedFile (const std::string & path)
+			{
+#ifdef _WIN32
+				auto file = CreateFileA (path .c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+				if (file == INVALID_HANDLE_VALUE)
+					return;
+				LARGE_INTEGER size;
+				if (GetFileSizeEx (file, &size) && size .QuadPart > 0)
+				{
+					if (auto mapping = CreateFileMappingA (file, nullptr, PAGE_READONLY, 0, 0, nullptr))
+					{
+						if ((_data = MapViewOfFile (mapping, FILE_MAP_READ, 0, 0, 0)))
+							_size = static_cast<size_t> (size .QuadPart);
+						CloseHandle (mapping);
+					}
+				}
+				CloseHandle (file);
+#else
+				auto fd = open (path .c_str(), O_RDONLY | O_CLOEXEC);
+				if (fd < 0)
+					return;
+				struct stat status;
+				if (fstat (fd, &status) == 0 && status .st_size > 0)
+				{
+					auto data = mmap (nullptr, static_cast<size_t> (status .st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+					if (data != MAP_FAILED)
+					{
+						_data = data;
+						_size = static_cast<size_t> (status .st_size);
+						// the parser reads the file once from start to end
+						madvise (_data, _size, MADV_SEQUENTIAL);
+						if (_size >= LargeFile)
+							madvise (_data, _size, MADV_WILLNEED);
+					}
+				}
+				close (fd);		// the mapping holds its own reference to the file
+#endif
+			}
+			~MappedFile()
+			{
+				if (!_data)
+					return;
+#ifdef _WIN32
+				UnmapViewOfFile (_data);
+#else
+				munmap (_data, _size);
+#endif
+			}
+			MappedFile (const MappedFile &) = delete;
+			MappedFile & operator = (const MappedFile &) = delete;
+
+			explicit operator bool() const { return _data != nullptr; }
+			std::string_view View() const { return {static_cast<const char *> (_data), _size}; }
+
+		private:
+			void * _data {nullptr};
+			size_t _size {0};
+		};	// MappedFile
+
+
+		// parse an XML file, returning the tinyxml2 error
+		inline XMLError parse_file (XMLDocument & doc, const std::string & path)
+		{
+			MappedFile file (path);
+			if (!file)
+				return doc .LoadFile (path .c_str());		// empty or unreadable, tinyxml2 will tell us which
+			auto xml = file .View();
+			return doc .Parse (xml .data(), xml .size());
+		}
+
+
+		// load XML document from file
+		inline std::unique_ptr <XMLDocument> load_document_file (const std::string & path)
+		{
+			auto doc = std::make_unique <XMLDocument>();
+			MappedFile file (path);
+			if (!file)
+			{
+				if (doc -> LoadFile (path .c_str()) != XML_SUCCESS)
+					throw_parse_error (*doc, {});
+				return doc;
+			}
+			auto xml = file .View();
+			if (doc -> Parse (xml .data(), xml .size()) != XML_SUCCESS)
+				throw_parse_error (*doc, xml);
+			return doc;
+		}
+
+
+		class StreamSelection
+		{
+			// the elements selected by an XPath from XML read in chunks from a file, or held in memory, without building the document
+			// each selected element is parsed, with its subtree, into a document of its own so memory is bounded by the largest of them
+			// elements are matched as a selection on the whole document would match them, except that
+			// an element within one already selected is part of it, not selected separately, and [last()] can't be known in time so is refused
+		public:
+			static constexpr size_t ChunkSize = 1 << 16;
+
+			// read from an open file descriptor, which is left open
+			StreamSelection (int fd, const XPath & xpath, size_t chunkSize = ChunkSize) : _xpath (xpath), _fd (fd), _chunkSize (chunkSize) { start(); }
+			StreamSelection (const std::string & path, const XPath & xpath, size_t chunkSize = ChunkSize) : _xpath (xpath), _chunkSize (chunkSize)
+			{
+				start();
+#ifdef _WIN32
+				_fd = _open (path .c_str(), _O_RDONLY | _O_BINARY);
+#else
+				_fd = open (path .c_str(), O_RDONLY | O_CLOEXEC);
+#endif
+				if (_fd < 0)
+					throw XmlException ("cannot open "s + path);
+				_owned = true;
+			}
+			// read from XML held in memory, which must outlive the selection, reading stops with the last element selected
+			StreamSelection (const char * xml, size_t length, const XPath & xpath) : _xpath (xpath), _eof (true), _text (xml, length) { start(); }
+			~StreamSelection()
+			{
+				if (!_owned)
+					return;
+#ifdef _WIN32
+				_close (_fd);
+#else
+				close (_fd);
+#endif
+			}
+			StreamSelection (const StreamSelection &) = delete;
+			StreamSelection & operator = (const StreamSelection &) = delete;
+
+			// the next selected element, nullptr at the end of the input
+			// its document is reused, so the element is valid until the next call
+			XMLElement * Next()
+			{
+				for (;;)
+				{
+					_token = _pos;
+					auto lt = search ("<", _pos);
+					if (lt == std::string::npos)
+					{
+						if (_depth > 0 || _passive > 0)
+							fail (XML_ERROR_PARSING, "unexpected end of XML"s, _text .size());
+						return nullptr;
+					}
+					_token = _pos = lt;
+					available (9);
+					std::string_view tag {_text .data() + _pos, std::min <size_t> (_text .size() - _pos, 9)};
+					if (tag .substr (0, 4) == "<!--")
+						_pos = past ("-->", 4);
+					else if (tag == "<![CDATA[")
+						_pos = past ("]]>", 9);
+					else if (tag .substr (0, 2) == "<?")
+						_pos = past ("?>", 2);
+					else if (tag .substr (0, 2) == "<!")
+						_pos = tag_end (true) + 1;
+					else if (tag .substr (0, 2) == "</")
+					{
+						_pos = past (">", 2);
+						if (_passive > 0)
+						{
+							if (--_passive == 0 && _capture != std::string::npos)
+								return selected (_capture, _pos);
+						}
+						else if (_depth == 0)
+							fail (XML_ERROR_MISMATCHED_ELEMENT, "unexpected end tag"s, _token);
+						else
+							--_depth;
+					}
+					else
+					{
+						auto end = tag_end (false);
+						_pos = end + 1;
+						bool empty = _text [end - 1] == '/';
+						if (_passive > 0)
+						{
+							if (!empty)
+								++_passive;
+						}
+						else if (open_element (end - (empty ? 1 : 0)))
+						{
+							if (empty)
+								return selected (_token, _pos);
+							_capture = _token;
+							_passive = 1;
+						}
+						else if (!empty)
+						{
+							if (_levels [_depth + 1] .candidates == 0)
+								_passive = 1;	// nothing below can be selected, skip the subtree
+							else
+								++_depth;
+						}
+					}
+				}
+			}
+
+			// take the document of the element last selected, the next is parsed into a new document
+			std::unique_ptr <XMLDocument> Release() { return std::move (_doc); }
+
+		private:
+			struct Level
+			{
+				uint64_t candidates;	// steps a child element may match
+				uint64_t ancestors;		// descendant steps reachable from this element or an ancestor
+				std::vector<size_t> counts;	// siblings matching each positional step so far
+			};
+
+			void start()
+			{
+				if (_xpath .Size() >= 64)
+					throw XmlException ("XPath exceeds capacity"s);
+				for (size_t ixStep = 0; ixStep < _xpath .Size(); ++ixStep)
+				{
+					if (_xpath .Last (ixStep))
+						throw XmlException ("[last()] in streamed XPath"s);
+					_positioned |= _xpath .Position (ixStep) > 0;
+					(_xpath .Descendant (ixStep) ? _descendantSteps : _childSteps) |= uint64_t {1} << ixStep;
+				}
+				// the document, below which only the document element is matched by the first step
+				// as in a selection, a path naming only the document element selects nothing
+				bool none = _xpath .Empty() || (_xpath .Size() == 1 && !_xpath .Descendant (0));
+				_levels .push_back (Level {none ? 0u : 1u, 1u, std::vector<size_t> (_positioned ? _xpath .Size() : 0)});
+			}
+
+			// match the start tag of an element ending at end against the steps its parent allows, true if it's selected
+			bool open_element (size_t end)
+			{
+				auto nameEnd = _token + 1;
+				while (nameEnd < end && !strchr (" \t\r\n/>", _text [nameEnd]))
+					++nameEnd;
+				std::string_view name {_text .data() + _token + 1, nameEnd - _token - 1};
+				_attributes .clear();
+				bool attributesRead = false;
+
+				auto & parent = _levels [_depth];
+				uint64_t matched = 0;
+				for (auto steps = parent .candidates; steps; steps &= steps - 1)
+				{
+					size_t ixStep = 0;
+					while (!(steps & (uint64_t {1} << ixStep)))
+						++ixStep;
+					if (ixStep == 0 && _depth == 0 && !_xpath .Descendant (0))
+					{
+						// only the name of the document element is checked, as in a selection
+						auto stepName = _xpath .Name (0);
+						if (*stepName && name != stepName)
+							throw XmlException ("document element name mismatch"s);
+						matched |= 1;
+						continue;
+					}
+					if (auto stepName = _xpath .Name (ixStep); *stepName && name != stepName)
+						continue;
+					if (_xpath .Filters (ixStep) > 0)
+					{
+						if (!attributesRead)
+						{
+							read_attributes (nameEnd, end);
+							attributesRead = true;
+						}
+						if (!filtered (ixStep))
+							continue;
+					}
+					if (auto position = _xpath .Position (ixStep); position > 0 && ++parent .counts [ixStep] != position)
+						continue;
+					matched |= uint64_t {1} << ixStep;
+				}
+				if (matched & (uint64_t {1} << (_xpath .Size() - 1)))
+					return true;
+
+				if (_levels .size() == _depth + 1)
+					_levels .emplace_back();
+				auto & level = _levels [_depth + 1];
+				level .ancestors = _levels [_depth] .ancestors | (matched << 1);
+				level .candidates = ((matched << 1) & _childSteps) | (level .ancestors & _descendantSteps);
+				if (_positioned)
+					level .counts .assign (_xpath .Size(), 0);
+				return false;
+			}
+
+			void read_attributes (size_t from, size_t end)
+			{
+				auto blank = [] (char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\n'; };
+				for (auto pos = from; pos < end; )
+				{
+					while (pos < end && blank (_text [pos]))
+						++pos;
+					auto nameStart = pos;
+					while (pos < end && !blank (_text [pos]) && _text [pos] != '=')
+						++pos;
+					std::string_view name {_text .data() + nameStart, pos - nameStart};
+					while (pos < end && (blank (_text [pos]) || _text [pos] == '='))
+						++pos;
+					if (pos >= end || (_text [pos] != '"' && _text [pos] != '\''))
+						break;
+					auto quote = _text [pos++];
+					auto valueStart = pos;
+					while (pos < end && _text [pos] != quote)
+						++pos;
+					_attributes .emplace_back (name, std::string_view {_text .data() + valueStart, pos - valueStart});
+					++pos;
+				}
+			}
+
+			// the element's attributes satisfy the attribute filters of step
+			bool filtered (size_t ixStep)
+			{
+				for (size_t ixFilter = 0; ixFilter < _xpath .Filters (ixStep); ++ixFilter)
+				{
+					std::string_view name {_xpath .FilterName (ixStep, ixFilter)}, value {_xpath .FilterValue (ixStep, ixFilter)};
+					auto attribute = std::find_if (_attributes .begin(), _attributes .end(), [name] (auto const & attribute) { return attribute .first == name; });
+					if (attribute == _attributes .end())
+						return false;
+					if (!value .empty() && decoded (attribute -> second) != value)
+						return false;
+				}
+				return true;
+			}
+
+			// attribute value with character and predefined entity references replaced, as tinyxml2 reads it
+			std::string_view decoded (std::string_view raw)
+			{
+				if (raw .find ('&') == std::string_view::npos)
+					return raw;
+				_decoded .clear();
+				for (size_t pos = 0; pos < raw .size(); ++pos)
+				{
+					auto semicolon = raw [pos] == '&' ? raw .find (';', pos) : std::string_view::npos;
+					if (semicolon == std::string_view::npos)
+					{
+						_decoded += raw [pos];
+						continue;
+					}
+					auto entity = raw .substr (pos + 1, semicolon - pos - 1);
+					static const std::pair<std::string_view, char> predefined [] {{"lt", '<'}, {"gt", '>'}, {"amp", '&'}, {"quot", '"'}, {"apos", '\''}};
+					auto known = std::find_if (std::begin (predefined), std::end (predefined), [entity] (auto const & p) { return p .first == entity; });
+					uint32_t code = 0;
+					if (known != std::end (predefined))
+						_decoded += known -> second;
+					else if (entity .size() > 1 && entity [0] == '#'
+							&& std::from_chars (entity .data() + (entity [1] == 'x' ? 2 : 1), entity .data() + entity .size(), code, entity [1] == 'x' ? 16 : 10) .ec == std::errc())
+					{
+						// UTF-8
+						if (code < 0x80)
+							_decoded += static_cast<char> (code);
+						else if (code < 0x800)
+							_decoded += {static_cast<char> (0xC0 | code >> 6), static_cast<char> (0x80 | (code & 0x3F))};
+						else if (code < 0x10000)
+							_decoded += {static_cast<char> (0xE0 | code >> 12), static_cast<char> (0x80 | (code >> 6 & 0x3F)), static_cast<char> (0x80 | (code & 0x3F))};
+						else
+							_decoded += {static_cast<char> (0xF0 | code >> 18), static_cast<char> (0x80 | (code >> 12 & 0x3F)), static_cast<char> (0x80 | (code >> 6 & 0x3F)), static_cast<char> (0x80 | (code & 0x3F))};
+					}
+					else
+					{
+						_decoded += raw [pos];
+						continue;
+					}
+					pos = semicolon;
+				}
+				return _decoded;
+			}
+
+			// parse the selected element from begin to end into the document
+			XMLElement * selected (size_t begin, size_t end)
+			{
+				_capture = std::string::npos;
+				if (!_doc)
+					_doc = std::make_unique <XMLDocument>();
+				if (_doc -> Parse (_text .data() + begin, end - begin) != XML_SUCCESS)
+				{
+					auto at = begin;
+					for (auto line = _doc -> ErrorLineNum(); line > 1 && at < end; --line)
+						at = _text .find ('\n', at) + 1;
+					fail (_doc -> ErrorID(), _doc -> ErrorStr(), at);
+				}
+				return _doc -> RootElement();
+			}
+
+			// read another chunk, first dropping what's no longer needed from the front of the buffer, false at the end of the input
+			// from, like the other offsets, is adjusted for the characters dropped
+			bool read (size_t & from)
+			{
+				if (_eof)
+					return false;
+				auto keep = std::min (_token, _capture);
+				if (keep > 0)
+				{
+					auto newline = _text .rfind ('\n', keep - 1);
+					if (newline != std::string::npos)
+					{
+						_lines += std::count (_text .begin(), _text .begin() + keep, '\n');
+						_lineStart = _discarded + newline + 1;
+					}
+					_buffer .erase (0, keep);
+					_discarded += keep;
+					_pos -= keep;
+					_token -= keep;
+					if (_capture != std::string::npos)
+						_capture -= keep;
+					from -= keep;
+				}
+				auto size = _buffer .size();
+				_buffer .resize (size + _chunkSize);
+#ifdef _WIN32
+				auto n = _read (_fd, &_buffer [size], static_cast<unsigned> (_chunkSize));
+#else
+				auto n = ::read (_fd, &_buffer [size], _chunkSize);
+#endif
+				if (n < 0)
+					throw XmlException ("error reading XML"s);
+				_buffer .resize (size + static_cast<size_t> (n));
+				_text = _buffer;
+				_eof = n == 0;
+				return !_eof;
+			}
+
+			// position of text, searching from, reading more of the input as necessary
+			size_t search (std::string_view text, size_t from)
+			{
+				for (;;)
+				{
+					auto at = _text .find (text, from);
+					if (at != std::string::npos)
+						return at;
+					if (_text .size() >= text .size())
+						from = std::max (from, _text .size() - text .size() + 1);
+					if (!read (from))
+						return std::string::npos;
+				}
+			}
+
+			void available (size_t n)
+			{
+				auto from = _pos;
+				while (_text .size() < _pos + n && read (from))
+					;
+			}
+
+			// position after the text closing the current token, skipping the text that opened it
+			size_t past (std::string_view text, size_t skip)
+			{
+				auto at = search (text, _pos + skip);
+				if (at == std::string::npos)
+					fail (XML_ERROR_PARSING, "unexpected end of XML"s, _token);
+				return at + text .size();
+			}
+
+			// position of the '>' closing a tag, skipping quoted values and, for a declaration, its internal subset
+			size_t tag_end (bool declaration)
+			{
+				char quote = 0;
+				int nested = 0;
+				for (auto pos = _pos + 1; ; ++pos)
+				{
+					if (pos == _text .size() && !read (pos))
+						fail (XML_ERROR_PARSING, "unexpected end of XML"s, _token);
+					auto c = _text [pos];
+					if (quote)
+						quote = c == quote ? 0 : quote;
+					else if (c == '"' || c == '\'')
+						quote = c;
+					else if (declaration && (c == '[' || c == ']'))
+						nested += c == '[' ? 1 : -1;
+					else if (c == '>' && nested == 0)
+						return pos;
+				}
+			}
+
+			[[noreturn]] void fail (XMLError error, const std::string & message, size_t at)
+			{
+				at = std::min (at, _text .size());
+				auto line = 1 + _lines + std::count (_text .begin(), _text .begin() + at, '\n');
+				auto newline = at > 0 ? _text .rfind ('\n', at - 1) : std::string::npos;
+				auto offset = newline != std::string::npos ? _discarded + newline + 1 : _lineStart;
+				throw XmlParseError ("error in XML at line "s + std::to_string (line) + " (offset "s + std::to_string (offset) + ") : "s + message,
+						error, static_cast<int> (line), offset);
+			}
+
+			XPath _xpath;
+			int _fd {-1};
+			bool _owned {false};
+			size_t _chunkSize {0};
+			bool _eof {false};
+			std::string _buffer;	// chunks read from the file
+			std::string_view _text;	// the buffer, or XML held in memory
+			size_t _pos {0};		// next character to read
+			size_t _token {0};		// start of the markup being read, kept in the buffer when reading more
+			size_t _capture {std::string::npos};	// start of the selected element being read
+			size_t _discarded {0};	// characters dropped from the front of the buffer
+			size_t _lines {0};		// and the lines they ended
+			size_t _lineStart {0};
+			uint64_t _childSteps {0}, _descendantSteps {0};
+			bool _positioned {false};
+			std::vector<Level> _levels;	// for each open element being matched, the document first
+			size_t _depth {0};
+			size_t _passive {0};	// open elements in a subtree being skipped or selected, which are only counted
+			std::vector<std::pair<std::string_view, std::string_view>> _attributes;
+			std::string _decoded;
+			std::unique_ptr <XMLDocument> _doc;
+		};	// StreamSelection
+
+
+		// the first element selected by xpath from XML held in memory, in a document of its own, or nullptr
+		// the XML is parsed only as far as the end of that element
+		inline std::unique_ptr <XMLDocument> find_first_in_buffer (std::string_view xml, const XPath & xpath)
+		{
+			StreamSelection stream (xml .data(), xml .size(), xpath);
+			return stream .Next() ? stream .Release() : nullptr;
+		}
+
+
+		// call fn for each element selected by xpath from a file, or a file descriptor, read in chunks
+		// fn is given the element in a document of its own, valid only for the call, and may return false to stop
+		template <typename S, typename F>
+		inline void stream_selection (S && source, const XPath & xpath, F fn)
+		{
+			StreamSelection stream (std::forward<S> (source), xpath);
+			while (auto element = stream .Next())
+			{
+				if constexpr (std::is_same_v<std::invoke_result_t<F &, XMLElement *>, bool>)
+				{
+					if (!fn (element))
+						return;
+				}
+				else
+					fn (element);
+			}
+		}
+	}
+}
@@ -0,0 +1,529 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+tixml2px.h implements the parallel operations of tinyxml2ex
+these work through a selection on a pool of threads, splitting it into independent subtrees, and load batches of documents concurrently
+it is separate from the base tinyxml2 extensions because it uses the standard thread library
+
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <iterator>
+#ifndef __TINYXML_EX__
+#include <tixml2ex.h>
+#endif // !__TINYXML_EX__
+#include <tixml2fx.h>
+
+namespace tinyxml2
+{
+	inline namespace tixml2ex
+	{
+		class ThreadPool
+		{
+			// a fixed set of worker threads, each taking tasks from its own queue and, when that is empty, stealing from the others
+			// a thread calling Run() works through queued tasks too, so tasks may themselves run tasks on the pool
+		public:
+			explicit ThreadPool (size_t nThreads = 0)	// 0 for one thread per hardware thread
+			{
+				if (nThreads == 0)
+					nThreads = std::max (1u, std::thread::hardware_concurrency());
+				for (size_t ix = 0; ix < nThreads; ++ix)
+					_queues .push_back (std::make_unique<Queue>());
+				for (size_t ix = 0; ix < nThreads; ++ix)
+					_workers .emplace_back ([this, ix] { work (ix); });
+			}
+			~ThreadPool()
+			{
+				// queued tasks are completed first
+				{
+					std::lock_guard<std::mutex> lock (_mutex);
+					_stop = true;
+				}
+				_wake .notify_all();
+				for (auto & worker : _workers)
+					worker .join();
+			}
+			ThreadPool (const ThreadPool &) = delete;
+			ThreadPool & operator = (const ThreadPool &) = delete;
+
+			size_t Size() const { return _workers .size(); }
+
+			// queue a task, tasks are spread across the workers' queues
+			void Submit (std::function<void()> task)
+			{
+				auto & queue = *_queues [_next++ % _queues .size()];
+				{
+					// counted before it can be taken, so the count never drops below the tasks queued
+					std::lock_guard<std::mutex> lock (_mutex);
+					++_queued;
+					std::lock_guard<std::mutex> queued (queue .mutex);
+					queue .tasks .push_back (std::move (task));
+				}
+				_wake .notify_one();
+			}
+
+			// run tasks and return when all have completed, rethrowing the first exception thrown by any of them
+			void Run (std::vector<std::function<void()>> tasks)
+			{
+				Batch batch (tasks .size());
+				for (auto & task : tasks)
+				{
+					Submit ([&batch, task = std::move (task)]
+					{
+						try
+						{
+							task();
+						}
+						catch (...)
+						{
+							batch .Fail (std::current_exception());
+						}
+						batch .Done();
+					});
+				}
+				// help until there's nothing left to take, then wait for the tasks still running
+				while (!batch .Complete())
+				{
+					if (!RunOne())
+						batch .Wait();
+				}
+				batch .Rethrow();
+			}
+
+			// run one queued task on the calling thread, false if there was none
+			// a thread waiting on tasks it submitted can help rather than block, and when this fails they have all been taken
+			bool RunOne()
+			{
+				std::function<void()> task;
+				if (!take (_next++ % _queues .size(), task))
+					return false;
+				task();
+				return true;
+			}
+
+		private:
+			struct Queue
+			{
+				std::mutex mutex;
+				std::deque<std::function<void()>> tasks;
+			};
+
+			class Batch
+			{
+				// completion of the tasks given to Run()
+			public:
+				explicit Batch (size_t nTasks) : _remaining (nTasks) {}
+
+				void Done()
+				{
+					std::lock_guard<std::mutex> lock (_mutex);
+					if (--_remaining == 0)
+						_done .notify_all();
+				}
+				void Fail (std::exception_ptr error)
+				{
+					std::lock_guard<std::mutex> lock (_mutex);
+					if (!_error)
+						_error = error;
+				}
+				bool Complete()
+				{
+					std::lock_guard<std::mutex> lock (_mutex);
+					return _remaining == 0;
+				}
+				void Wait()
+				{
+					std::unique_lock<std::mutex> lock (_mutex);
+					_done .wait (lock, [this] { return _remaining == 0; });
+				}
+				void Rethrow() const
+				{
+					if (_error)
+						std::rethrow_exception (_error);
+				}
+
+			private:
+				std::mutex _mutex;
+				std::condition_variable _done;
+				size_t _remaining;
+				std::exception_ptr _error;
+			};	// Batch
+
+			bool take (size_t ix, std::function<void()> & task)
+			{
+				// newest task from our own queue, otherwise the oldest from another
+				for (size_t n = 0; n < _queues .size(); ++n)
+				{
+					auto & queue = *_queues [(ix + n) % _queues .size()];
+					{
+						std::lock_guard<std::mutex> lock (queue .mutex);
+						if (queue .tasks .empty())
+							continue;
+						if (n == 0)
+						{
+							task = std::move (queue .tasks .back());
+							queue .tasks .pop_back();
+						}
+						else
+						{
+							task = std::move (queue .tasks .front());
+							queue .tasks .pop_front();
+						}
+					}
+					std::lock_guard<std::mutex> lock (_mutex);
+					--_queued;
+					return true;
+				}
+				return false;
+			}
+
+			void work (size_t ix)
+			{
+				std::function<void()> task;
+				for (;;)
+				{
+					if (take (ix, task))
+					{
+						task();
+						continue;
+					}
+					std::unique_lock<std::mutex> lock (_mutex);
+					_wake .wait (lock, [this] { return _stop || _queued > 0; });
+					if (_stop && _queued == 0)
+						return;
+				}
+			}
+
+			std::vector<std::unique_ptr<Queue>> _queues;
+			std::vector<std::thread> _workers;
+			std::atomic<size_t> _next {0};
+			std::mutex _mutex;
+			std::condition_variable _wake;
+			size_t _queued {0};
+			bool _stop {false};
+		};	// ThreadPool
+
+
+		// a pool with a thread per hardware thread, for parallel operations not given a pool
+		inline ThreadPool & shared_pool()
+		{
+			static ThreadPool pool;
+			return pool;
+		}
+
+
+		// pre-order successor of node within the subtree of top, nullptr when the subtree is exhausted
+		inline const XMLNode * next_node (const XMLNode * node, const XMLNode * top)
+		{
+			if (auto child = node -> FirstChild())
+				return child;
+			for (; node && node != top; node = node -> Parent())
+			{
+				if (auto sibling = node -> NextSibling())
+					return sibling;
+			}
+			return nullptr;
+		}
+
+
+		// tinyxml2 normalises names, values and text when they are first read, which writes to the document
+		// priming reads them all once, after which a document that isn't modified can be read from any number of threads
+		inline void prime_node (const XMLNode * node)
+		{
+			node -> Value();
+			if (auto element = node -> ToElement())
+			{
+				for (auto attribute = element -> FirstAttribute(); attribute; attribute = attribute -> Next())
+				{
+					attribute -> Name();
+					attribute -> Value();
+				}
+			}
+		}
+
+		inline void prime (const XMLNode * top)
+		{
+			for (auto node = top; node; node = next_node (node, top))
+				prime_node (node);
+		}
+
+
+		// call fn for each element of the selection, concurrently on the pool
+		// the selection is split after step, by default its last, and each element matching the path up to step is a subtree worked through by one task
+		// the document is primed first, so fn may read any of it, but it must not modify the document
+		// (tinyxml2 allocates nodes and attributes from per-document pools that are not thread-safe)
+		// fn is called in no particular order, the first exception it throws is rethrown once all tasks have finished
+		template <typename XE, typename F>
+		inline void parallel_for_each (const Selector<XE> & selection, F fn, ThreadPool & pool, std::optional<size_t> step = {})
+		{
+			auto const & xpath = selection .Path();
+			if (xpath .Empty())
+				return;
+			auto split = step .value_or (xpath .Size() - 1);
+			if (split >= xpath .Size() || (xpath .Absolute() && !xpath .Descendant (0) && split == 0))
+				throw XmlException ("no step to split selection at"s);
+			bool whole = split == xpath .Size() - 1;	// each selected element is a subtree
+			if (!whole)
+			{
+				if (selection .Windowed())
+					throw XmlException ("cannot split a windowed selection"s);
+				bool above = false, below = false;
+				for (size_t ixStep = 0; ixStep < xpath .Size(); ++ixStep)
+					(ixStep <= split ? above : below) |= xpath .Descendant (ixStep);
+				if (above && below)
+					throw XmlException ("cannot split selection between descendant steps"s);	// subtrees could select the same elements
+			}
+
+			// the subtrees, in document order
+			std::vector<XE *> parts;
+			for (auto element : whole ? selection : selection .Head (split))
+				parts .push_back (element);
+			if (parts .empty())
+				return;
+
+			// tasks each take a run of subtrees, enough of them to keep the pool busy as they finish unevenly
+			auto nTasks = std::min (parts .size(), (pool .Size() + 1) * 8);
+			auto make_tasks = [&] (auto each)
+			{
+				std::vector<std::function<void()>> tasks;
+				for (size_t ixTask = 0; ixTask < nTasks; ++ixTask)
+				{
+					auto from = parts .size() * ixTask / nTasks;
+					auto to = parts .size() * (ixTask + 1) / nTasks;
+					tasks .push_back ([&parts, each, from, to] { for (auto ix = from; ix < to; ++ix) each (parts [ix]); });
+				}
+				return tasks;
+			};
+
+			// prime the document outside the subtrees here and each subtree in parallel, unless subtrees nest
+			const XMLNode * doc = parts .front() -> GetDocument();
+			bool nested = false;
+			for (size_t ix = 1, ixOuter = 0; ix < parts .size() && !nested; ++ix)
+			{
+				for (const XMLNode * node = parts [ix] -> Parent(); node && !nested; node = node -> Parent())
+					nested = node == parts [ixOuter];
+				ixOuter = ix;
+			}
+			if (nested)
+				prime (doc);
+			else
+			{
+				size_t ixPart = 0;
+				for (auto node = doc; node; )
+				{
+					if (ixPart < parts .size() && node == parts [ixPart])
+					{
+						// skip the subtree
+						++ixPart;
+						const XMLNode * next = nullptr;
+						for (auto up = node; !next && up && up != doc; up = up -> Parent())
+							next = up -> NextSibling();
+						node = next;
+					}
+					else
+					{
+						prime_node (node);
+						node = next_node (node, doc);
+					}
+				}
+				pool .Run (make_tasks ([] (XE * part) { prime (part); }));
+			}
+
+			if (whole)
+				pool .Run (make_tasks ([&fn] (XE * part) { fn (part); }));
+			else
+				pool .Run (make_tasks ([&fn, &selection, split] (XE * part) { for (auto element : selection .Tail (part, split)) fn (element); }));
+		}
+
+		template <typename XE, typename F>
+		inline void parallel_for_each (const Selector<XE> & selection, F fn, std::optional<size_t> step = {})
+		{
+			parallel_for_each (selection, fn, shared_pool(), step);
+		}
+
+
+		// the outcome of loading one document of a batch
+		struct LoadResult
+		{
+			std::unique_ptr <XMLDocument> document;	// nullptr unless loaded
+			XMLError error {XML_SUCCESS};
+			int line {0};			// of the error, when tinyxml2 reports one
+			std::string message;
+
+			explicit operator bool() const { return !!document; }
+		};	// LoadResult
+
+
+		// load a batch of documents concurrently on the pool, calling fn (index, result) on the calling thread in input order
+		// load (index, doc) loads the indexed document into doc, returning the tinyxml2 error
+		// at most maxInFlight documents are loaded but not yet passed to fn, holding memory to that many documents however large the batch
+		// a document that fails to load is passed to fn with its error and the batch carries on
+		template <typename L, typename F>
+		inline void load_batch (size_t nDocuments, L load, F fn, ThreadPool & pool, size_t maxInFlight)
+		{
+			maxInFlight = std::max <size_t> (maxInFlight, 1);
+			std::vector<LoadResult> slots (std::min (nDocuments, maxInFlight));
+			std::vector<char> ready (slots .size(), false);
+			std::vector<std::exception_ptr> errors (slots .size());
+			std::mutex mutex;
+			std::condition_variable loaded;
+			size_t nSubmitted = 0, nCompleted = 0;
+
+			// tasks still in flight when fn throws refer to the above, so let them finish
+			struct Drain
+			{
+				ThreadPool & pool;
+				std::mutex & mutex;
+				std::condition_variable & loaded;
+				size_t & nSubmitted, & nCompleted;
+				~Drain()
+				{
+					std::unique_lock<std::mutex> lock (mutex);
+					while (nCompleted != nSubmitted)
+					{
+						lock .unlock();
+						bool helped = pool .RunOne();
+						lock .lock();
+						if (!helped)
+							loaded .wait (lock, [this] { return nCompleted == nSubmitted; });
+					}
+				}
+			} drain {pool, mutex, loaded, nSubmitted, nCompleted};
+
+			for (size_t ix = 0; ix < nDocuments; ++ix)
+			{
+				for (; nSubmitted < nDocuments && nSubmitted < ix + slots .size(); ++nSubmitted)
+				{
+					pool .Submit ([&, ixDocument = nSubmitted]
+					{
+						LoadResult result;
+						std::exception_ptr error;
+						try
+						{
+							auto doc = std::make_unique <XMLDocument>();
+							result .error = load (ixDocument, *doc);
+							if (result .error == XML_SUCCESS)
+								result .document = std::move (doc);
+							else
+							{
+								result .line = doc -> ErrorLineNum();
+								result .message = doc -> ErrorStr();
+							}
+						}
+						catch (...)
+						{
+							error = std::current_exception();
+						}
+						// notify while locked, the waiting thread may return as soon as it sees the count
+						std::lock_guard<std::mutex> lock (mutex);
+						auto ixSlot = ixDocument % slots .size();
+						slots [ixSlot] = std::move (result);
+						errors [ixSlot] = error;
+						ready [ixSlot] = true;
+						++nCompleted;
+						loaded .notify_all();
+					});
+				}
+
+				// help with loading until this document is ready
+				auto ixSlot = ix % slots .size();
+				std::unique_lock<std::mutex> lock (mutex);
+				while (!ready [ixSlot])
+				{
+					lock .unlock();
+					bool helped = pool .RunOne();
+					lock .lock();
+					if (!helped)
+						loaded .wait (lock, [&] { return !!ready [ixSlot]; });
+				}
+				auto result = std::move (slots [ixSlot]);
+				auto error = std::move (errors [ixSlot]);
+				ready [ixSlot] = false;
+				lock .unlock();
+				if (error)
+					std::rethrow_exception (error);
+				fn (ix, std::move (result));
+			}
+		}
+
+
+		// iterators to each of items, so that any item is reached in constant time from any thread, whatever kind of range holds them
+		template <typename S>
+		inline auto item_iterators (const S & items)
+		{
+			std::vector<decltype (std::begin (items))> iterators;
+			for (auto item = std::begin (items); item != std::end (items); ++item)
+				iterators .push_back (item);
+			return iterators;
+		}
+
+
+		// parse XML held in memory, each item of xmlStrings being convertible to std::string_view
+		template <typename S, typename F>
+		inline void load_documents (const S & xmlStrings, F fn, ThreadPool & pool, size_t maxInFlight)
+		{
+			auto items = item_iterators (xmlStrings);
+			load_batch (items .size(),
+				[&items] (size_t ix, XMLDocument & doc)
+				{
+					std::string_view xml {*items [ix]};
+					return doc .Parse (xml .data(), xml .size());
+				},
+				fn, pool, maxInFlight);
+		}
+
+		// load XML files, each item of paths being convertible to std::string
+		template <typename S, typename F>
+		inline void load_document_files (const S & paths, F fn, ThreadPool & pool, size_t maxInFlight)
+		{
+			auto items = item_iterators (paths);
+			load_batch (items .size(),
+				[&items] (size_t ix, XMLDocument & doc) { return parse_file (doc, std::string (*items [ix])); },
+				fn, pool, maxInFlight);
+		}
+
+
+		// the whole batch, in input order
+		template <typename S>
+		inline std::vector<LoadResult> load_documents (const S & xmlStrings, ThreadPool & pool = shared_pool())
+		{
+			std::vector<LoadResult> results;
+			load_documents (xmlStrings, [&results] (size_t, LoadResult && result) { results .push_back (std::move (result)); }, pool, std::numeric_limits<size_t>::max());
+			return results;
+		}
+
+		template <typename S>
+		inline std::vector<LoadResult> load_document_files (const S & paths, ThreadPool & pool = shared_pool())
+		{
+			std::vector<LoadResult> results;
+			load_document_files (paths, [&results] (size_t, LoadResult && result) { results .push_back (std::move (result)); }, pool, std::numeric_limits<size_t>::max());
+			return results;
+		}
+	}
+}
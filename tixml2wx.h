@@ -0,0 +1,408 @@
+/*
+tinyxml2ex - a set of add-on classes and helper functions bringing C++11/14/17 features, such as iterators, strings and exceptions, to tinyxml2
+
+tixml2wx.h implements writing XML as a stream, without first building a document
+elements are named with the same paths as append_element and written out as they are opened, so memory does not grow with the output
+it is separate from the base tinyxml2 extensions because it writes to file descriptors as well as streams and strings
+
+Copyright (c) 2017 Stan Thomas
+
+Permission is hereby granted, free of charge, to any person obtaining a copy of this software and associated documentation files (the "Software"),
+to deal in the Software without restriction, including without limitation the rights to use, copy, modify, merge, publish, distribute, sublicense,
+and/or sell copies of the Software, and to permit persons to whom the Software is furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS
+IN THE SOFTWARE.
+
+
+tinyxml2 is the work of Lee Thomason (www.grinninglizard.com) and others.
+It can be found here: https://github.com/leethomason/tinyxml2 and has it's own licensing terms.
+
+*/
+
+#pragma once
+
+#include <string>
+#include <string_view>
+#include <vector>
+#include <ostream>
+#include <type_traits>
+#include <exception>
+#include <cerrno>
+#include <cstring>
+#ifdef _WIN32
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+#ifndef __TINYXML_EX__
+#include <tixml2ex.h>
+#endif // !__TINYXML_EX__
+
+namespace tinyxml2
+{
+	inline namespace tixml2ex
+	{
+		class XmlWriter
+		{
+			// writes XML straight to a string, stream or file descriptor as elements are opened, closed and given content
+			// only the names of the open elements are held, so memory stays the same however much is written
+			// the layout is that of XMLPrinter, so the output is as if the same document had been built and printed
+		public:
+			explicit XmlWriter (std::string & out, bool compact = false) : _out (out), _compact (compact) {}
+			explicit XmlWriter (std::ostream & out, bool compact = false) : _out (_buffer), _stream (&out), _compact (compact) { _buffer .reserve (flushSize); }
+			explicit XmlWriter (int fd, bool compact = false) : _out (_buffer), _fd (fd), _compact (compact) { _buffer .reserve (flushSize); }
+			~XmlWriter()
+			{
+				// complete the document unless leaving because of an exception,
+				// when what has been written so far is flushed as it stands, its open elements left unclosed
+				try
+				{
+					if (std::uncaught_exceptions() > _uncaught)
+						Flush();
+					else
+						Finish();
+				}
+				catch (...) {}
+			}
+			XmlWriter (const XmlWriter &) = delete;
+			XmlWriter & operator = (const XmlWriter &) = delete;
+
+			// number of elements open
+			size_t Depth() const { return _offsets .size(); }
+
+			XmlWriter & Declaration (std::string_view declaration = "xml version=\"1.0\" encoding=\"UTF-8\"")
+			{
+				newLine();
+				_out += "<?";
+				_out += declaration;
+				_out += "?>";
+				return *this;
+			}
+
+			// open the elements of a path, relative to the innermost open element, with attributes from its filters
+			// attributes are given to the last element of the path, which is left innermost
+			// as append_element, the path may not have descendant steps or positional filters;
+			// a path from the document ('/') may only be opened when no element is open
+			XmlWriter & Open (const XPath & xpath, const attribute_list_t & attributes = {})
+			{
+				checkPath (xpath);
+				for (size_t ixStep = 0; ixStep < xpath .Size(); ++ixStep)
+				{
+					openElement (xpath .Name (ixStep));
+					for (size_t ixFilter = 0; ixFilter < xpath .Filters (ixStep); ++ixFilter)
+						Attribute (xpath .FilterName (ixStep, ixFilter), xpath .FilterValue (ixStep, ixFilter));
+				}
+				for (auto const & attribute : attributes)
+					Attribute (attribute .Name(), attribute .Value());
+				return checkFlush();
+			}
+			XmlWriter & Open (std::string_view xpath, const attribute_list_t & attributes = {}) { return Open (XPath (xpath), attributes); }
+
+			// add an attribute to the element just opened
+			XmlWriter & Attribute (std::string_view name, std::string_view value)
+			{
+				if (!_open)
+					throw XmlException ("attribute after element content"s);
+				_out += ' ';
+				_out += name;
+				_out += "=\"";
+				escape<true> (value);
+				_out += '"';
+				return *this;
+			}
+
+			XmlWriter & Text (std::string_view text)
+			{
+				if (_offsets .empty())
+					throw XmlException ("text outside document element"s);
+				_textDepth = (int) _offsets .size() - 1;
+				seal();
+				escape<false> (text);
+				return checkFlush();
+			}
+
+			XmlWriter & CData (std::string_view text)
+			{
+				if (_offsets .empty())
+					throw XmlException ("text outside document element"s);
+				_textDepth = (int) _offsets .size() - 1;
+				seal();
+				_out += "<![CDATA[";
+				_out += text;
+				_out += "]]>";
+				return checkFlush();
+			}
+
+			XmlWriter & Comment (std::string_view comment)
+			{
+				newLine();
+				_out += "<!--";
+				_out += comment;
+				_out += "-->";
+				return checkFlush();
+			}
+
+			// close the innermost n elements
+			XmlWriter & Close (size_t n = 1)
+			{
+				if (n > _offsets .size())
+					throw XmlException ("no element open to close"s);
+				while (n--)
+					closeElement();
+				return checkFlush();
+			}
+			XmlWriter & CloseAll() { return Close (_offsets .size()); }
+
+			// a complete element: open the path, give its last element text, then close all of it again
+			XmlWriter & Element (const XPath & xpath, const attribute_list_t & attributes = {}, std::string_view text = {})
+			{
+				auto depth = _offsets .size();
+				Open (xpath, attributes);
+				if (!text .empty())
+					Text (text);
+				return Close (_offsets .size() - depth);
+			}
+			XmlWriter & Element (std::string_view xpath, const attribute_list_t & attributes, std::string_view text) { return Element (XPath (xpath), attributes, text); }
+			XmlWriter & Element (std::string_view xpath, const attribute_list_t & attributes) { return Element (XPath (xpath), attributes, {}); }
+			XmlWriter & Element (std::string_view xpath, std::string_view text) { return Element (XPath (xpath), {}, text); }
+			XmlWriter & Element (std::string_view xpath) { return Element (XPath (xpath), {}, {}); }
+
+			// write a node of an existing document, with everything below it, where the next element would go
+			XmlWriter & Splice (const XMLNode * node)
+			{
+				if (!node)
+					throw XmlException ("null node"s);
+				if (node -> ToText())
+				{
+					_textDepth = (int) _offsets .size() - 1;
+					seal();
+				}
+				else
+					newLine();
+				_first = false;
+				// within text the node is written compact, XMLPrinter lays out what follows the first text below it
+				XMLPrinter printer (nullptr, _compact || _textDepth >= 0, (int) _offsets .size());
+				node -> Accept (&printer);
+				_out += printer .CStr();
+				return checkFlush();
+			}
+
+			// write out anything buffered, a string is always up to date
+			void Flush()
+			{
+				if (_stream)
+				{
+					_stream -> write (_buffer .data(), (std::streamsize) _buffer .size());
+					if (!*_stream)
+						throw XmlException ("unable to write XML to stream"s);
+				}
+				else if (_fd >= 0)
+				{
+					for (size_t done = 0; done < _buffer .size(); )
+					{
+#ifdef _WIN32
+						auto n = ::_write (_fd, _buffer .data() + done, (unsigned) std::min (_buffer .size() - done, (size_t) 0x40000000));
+#else
+						auto n = ::write (_fd, _buffer .data() + done, _buffer .size() - done);
+#endif
+						if (n < 0 && errno == EINTR)
+							continue;
+						if (n <= 0)
+							throw XmlException ("unable to write XML : "s + strerror (errno));
+						done += (size_t) n;
+					}
+				}
+				else
+					return;
+				_buffer .clear();
+			}
+
+			// close any elements still open and write everything out
+			void Finish()
+			{
+				CloseAll();
+				Flush();
+			}
+
+		private:
+			static constexpr size_t flushSize = 64 * 1024;
+
+			// characters each kind of value must escape, 0 for those copied as they are
+			struct Escapes
+			{
+				constexpr Escapes (bool attribute) : entity {}
+				{
+					entity [(unsigned char) '&'] = 1;
+					entity [(unsigned char) '<'] = 2;
+					entity [(unsigned char) '>'] = 3;
+					if (attribute)
+					{
+						entity [(unsigned char) '"'] = 4;
+						entity [(unsigned char) '\''] = 5;
+					}
+				}
+				unsigned char entity [256];
+			};
+
+			template <bool attribute>
+			void escape (std::string_view value)
+			{
+				static constexpr Escapes escapes {attribute};
+				static constexpr std::string_view entities [] {{}, "&amp;", "&lt;", "&gt;", "&quot;", "&apos;"};
+				// runs of ordinary characters are copied whole
+				auto run = value .data();
+				auto end = run + value .size();
+				for (auto ch = run; ch != end; ++ch)
+				{
+					if (auto entity = escapes .entity [(unsigned char) *ch])
+					{
+						_out .append (run, (size_t) (ch - run));
+						_out += entities [entity];
+						run = ch + 1;
+					}
+				}
+				_out .append (run, (size_t) (end - run));
+			}
+
+			void checkPath (const XPath & xpath)
+			{
+				if (xpath .Empty())
+					throw XmlException ("empty element path"s);
+				if (xpath .Absolute() && !_offsets .empty())
+					throw XmlException ("document path within open element"s);
+				for (size_t ixStep = 0; ixStep < xpath .Size(); ++ixStep)
+				{
+					if (xpath .Descendant (ixStep))
+						throw XmlException ("descendant step in element path"s);
+					if (xpath .Position (ixStep) || xpath .Last (ixStep))
+						throw XmlException ("positional filter in element path"s);
+					if (!*xpath .Name (ixStep))
+						throw XmlException ("unnamed step in element path"s);
+				}
+			}
+
+			// finish the start tag of the element just opened
+			void seal()
+			{
+				if (_open)
+				{
+					_out += '>';
+					_open = false;
+				}
+			}
+
+			// start a new line for markup other than text, as XMLPrinter
+			void newLine()
+			{
+				seal();
+				if (_textDepth < 0 && !_first && !_compact)
+				{
+					_out += '\n';
+					indent (_offsets .size());
+				}
+				_first = false;
+			}
+
+			void indent (size_t depth)
+			{
+				_out .append (depth * 4, ' ');
+			}
+
+			void openElement (const char * name)
+			{
+				newLine();
+				_out += '<';
+				_out += name;
+				_offsets .push_back (_names .size());
+				_names += name;
+				_open = true;
+			}
+
+			void closeElement()
+			{
+				auto offset = _offsets .back();
+				_offsets .pop_back();
+				auto depth = _offsets .size();
+				if (_open)
+					_out += "/>";
+				else
+				{
+					if (_textDepth < 0 && !_compact)
+					{
+						_out += '\n';
+						indent (depth);
+					}
+					_out += "</";
+					_out .append (_names, offset, std::string::npos);
+					_out += '>';
+				}
+				_names .resize (offset);
+				if (_textDepth == (int) depth)
+					_textDepth = -1;
+				if (depth == 0 && !_compact)
+					_out += '\n';
+				_open = false;
+			}
+
+			XmlWriter & checkFlush()
+			{
+				if (_out .size() >= flushSize && &_out == &_buffer)
+					Flush();
+				return *this;
+			}
+
+			std::string _buffer;
+			std::string & _out;
+			std::ostream * _stream {nullptr};
+			int _fd {-1};
+			bool _compact;
+			int _uncaught {std::uncaught_exceptions()};
+
+			// names of the open elements end to end, with the offset of each
+			std::string _names;
+			std::vector<size_t> _offsets;
+
+			bool _open {false};		// start tag not yet finished with '>'
+			bool _first {true};		// nothing written yet
+			int _textDepth {-1};		// depth of the element whose text is being written, its content is not laid out
+		};	// XmlWriter
+
+
+		inline void write_attribute (XmlWriter & writer, const AttributeNameValue & attribute)
+		{
+			writer .Attribute (attribute .Name(), attribute .Value());
+		}
+
+		template <typename N, typename V> inline void write_attribute (XmlWriter & writer, const std::pair<N, V> & attribute)
+		{
+			writer .Attribute (attribute .first, attribute .second);
+		}
+
+
+		// write an element built from xpath for each of records, as append_elements
+		// fn either writes the attributes and content of the final element, fn (record, writer), or projects the record to attributes,
+		// fn (record), returning a range of AttributeNameValue or of name and value pairs
+		template <typename R, typename F>
+		inline void write_elements (XmlWriter & writer, const XPath & xpath, const R & records, F fn)
+		{
+			for (auto const & record : records)
+			{
+				auto depth = writer .Depth();
+				writer .Open (xpath);
+				if constexpr (std::is_invocable_v<F &, decltype (record), XmlWriter &>)
+					fn (record, writer);
+				else
+				{
+					for (auto const & attribute : fn (record))
+						write_attribute (writer, attribute);
+				}
+				writer .Close (writer .Depth() - depth);
+			}
+		}
+	}
+}